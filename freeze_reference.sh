@@ -0,0 +1,13 @@
+#!/bin/bash
+# Copies the current simulator into src/reference (namespace r2sref), where it becomes the reference engine that robosoc2d_diff compares against.
+# Run it only after having accepted on purpose a change in the physics or in the rules.
+cd "$(dirname "$0")/src" || exit 1
+mkdir -p reference
+header="// frozen copy of the simulator, the reference engine of robosoc2d_diff. Do not edit: regenerate it with freeze_reference.sh"
+# the reference always uses the standard trigonometric functions, also when the simulator is compiled with _R2S_FAST_TRIG
+trig='s/\bf\(sincos\|sin\|cos\|atan2\|remainder\)(/r2s::stdtrig::\1(/g'
+sed -e "1a $header" -e 's/namespace r2s {/namespace r2sref {/' -e 's/VEC2_H/R2S_REF_VEC2_H/g' \
+    -e 's/#include "fast_trig.h"/#include "..\/fast_trig.h"/' -e "$trig" -e 's/^#ifdef _R2S_FLOAT/#if 0 \/\/ the reference engine is always in double precision/' vec2.h > reference/ref_vec2.h
+sed -e "1a $header" -e 's/namespace r2s { *$/namespace r2sref {\nusing namespace r2s; \/\/ only for the shared profiler.h/' -e 's/R2S_SIMULATOR_H/R2S_REF_SIMULATOR_H/g' \
+    -e 's/#include "vec2.h"/#include "ref_vec2.h"/' -e 's/#include "profiler.h"/#include "..\/profiler.h"/' simulator.h > reference/ref_simulator.h
+sed -e "1a $header" -e 's/namespace r2s {/namespace r2sref {/' -e 's/#include "simulator.h"/#include "ref_simulator.h"/' -e "$trig" simulator.cpp > reference/ref_simulator.cpp
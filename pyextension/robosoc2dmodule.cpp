@@ -808,6 +808,43 @@ static PyObject* pythonizeGameState(const R2GameState& gameState) {
     return pyGameState;
 }
 
+// fills target with an action expressed in Python as a sequence of one integer and three floats. Returns false if the sequence is not valid.
+bool fillR2Action(R2Action& target, PyObject *source){
+    if(!PySequence_Check(source)){
+        return false;
+    }
+
+    int len=(int)PySequence_Length(source);
+    if(len != 4){
+        return false;
+    }
+
+    PyObject *po = PySequence_GetItem(source, 0);
+    if (po == NULL){ 
+        return false;
+    }
+    if(!PyLong_Check(po)){
+        Py_DECREF(po);
+        return false;
+    }
+    target.action=static_cast<R2ActionType>((int)PyLong_AsLong(po));
+    Py_DECREF(po);
+
+    for(int i=0; i<3; i++){
+        po = PySequence_GetItem(source, i+1);
+        if (po == NULL){ 
+            return false;
+        }
+        if(!PyFloat_Check(po)){
+            Py_DECREF(po);
+            return false;
+        }
+        target.data[i]=PyFloat_AsDouble(po);
+        Py_DECREF(po);
+    }
+    return true;
+}
+
 static PyObject *stepMethodName;
 class PythonPlayer : public R2Player {
 private:
@@ -817,6 +854,7 @@ public:
     ~PythonPlayer(); 
 
     virtual R2Action step(const R2GameState gameState) override;
+    virtual bool isThreadSafe() override { return false; }  // it needs the GIL
 };
 
 R2Action PythonPlayer::step(const R2GameState gameState) {
@@ -836,45 +874,12 @@ R2Action PythonPlayer::step(const R2GameState gameState) {
             return R2Action();
         }
 
-        if(!PySequence_Check(result)){
-            Py_DECREF(result);  //check
-            return R2Action();
-        }
-
-        int len=(int)PySequence_Length(result);
-        if(len != 4){
-            Py_DECREF(result);  //check
-            return R2Action();
-        }
-
         R2Action playerAction;
-
-        PyObject *po = PySequence_GetItem(result, 0);
-        if (po == NULL){ 
-            Py_DECREF(result);  //check
-            return R2Action();
-        }
-        if(!PyLong_Check(po)){
-            Py_DECREF(po);
-            Py_DECREF(result);  //check
+        bool valid=fillR2Action(playerAction, result);
+        Py_DECREF(result);  //check
+        if(!valid){
             return R2Action();
         }
-        playerAction.action=static_cast<R2ActionType>((int)PyLong_AsLong(po));
-        Py_DECREF(po);
-
-        for(int i=0; i<3; i++){
-            po = PySequence_GetItem(result, i+1);
-            if (po == NULL){ 
-                return R2Action();
-            }
-            if(!PyFloat_Check(po)){
-                Py_DECREF(po);
-                return R2Action();
-            }
-            playerAction.data[i]=PyFloat_AsDouble(po);
-            Py_DECREF(po);
-        }
-        Py_DECREF(result);  //check
 
         return playerAction;    // only point in which the legit action from the python player is built and used
     }
@@ -1097,6 +1102,439 @@ static PyObject *robosoc2d_simulatorStepIfPlaying(PyObject *self, PyObject *args
     return PyBool_FromLong(long(simulations[handle]->stepIfPlaying()));
 }
 
+// returns a new dictionary containing the events
+static PyObject* pythonizeEvents(const R2Events& events){
+    return Py_BuildValue("{s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i}",
+        "ticks", events.ticks,
+        "goals1", events.goals[0],
+        "goals2", events.goals[1],
+        "ball_out", events.ballOut,
+        "kicks1", events.kicks[0],
+        "kicks2", events.kicks[1],
+        "touches1", events.touches[0],
+        "touches2", events.touches[1],
+        "catches1", events.catches[0],
+        "catches2", events.catches[1]);
+}
+
+static PyObject *robosoc2d_simulatorStepN(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"k", (char *)"actions", NULL};
+    int handle;
+    int k;
+    PyObject *pActions=NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ii|O", keywords, &handle, &k, &pActions)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+    auto& sim=simulations[handle];
+
+    std::vector<R2Action> actions;
+    std::vector<bool> given;
+    if((pActions != NULL) && (pActions != Py_None)){
+        if(!PySequence_Check(pActions)){
+            PyErr_SetString(PyExc_TypeError, "actions must be a sequence containing an action or None for each player");
+            return NULL;
+        }
+        int len=(int)PySequence_Length(pActions);
+        R2GameState state=sim->getGameState();
+        int players=int(state.env.teams[0].size()+state.env.teams[1].size());
+        if(len!=players){
+            PyErr_Format(PyExc_ValueError, "actions must contain an action or None for each of the %d players, it contains %d elements", players, len);
+            return NULL;
+        }
+        actions.resize(len);
+        given.resize(len, false);
+        for(int i=0; i<len; i++){
+            PyObject *pAction = PySequence_GetItem(pActions, i);
+            if (pAction == NULL){
+                PyErr_SetString(PyExc_TypeError, "unable to get action from sequence");
+                return NULL;
+            }
+            if(pAction != Py_None){
+                if(!fillR2Action(actions[i], pAction)){
+                    Py_DECREF(pAction);
+                    PyErr_SetString(PyExc_TypeError, "actions must be tuples composed by one integer and three floats, or None");
+                    return NULL;
+                }
+                given[i]=true;
+            }
+            Py_DECREF(pAction);
+        }
+    }
+
+    R2Events events=sim->stepN(k, actions, given);
+    bool playing= (sim->getGameState().env.state != R2State::Ended);
+
+    PyObject *pEvents=pythonizeEvents(events);
+    if(pEvents==NULL)
+        return NULL;
+    PyObject *pGameState=pythonizeGameState(sim->getGameState());
+    if(pGameState==NULL){
+        Py_DECREF(pEvents);
+        return NULL;
+    }
+    return Py_BuildValue("(NNN)", PyBool_FromLong((long)playing), pEvents, pGameState);
+}
+
+static PyObject *robosoc2d_simulatorGetEvents(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", NULL};
+    int handle;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "i", keywords, &handle)){
+        PyErr_SetString(PyExc_TypeError, "parameter must be an integer");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    return pythonizeEvents(simulations[handle]->getEvents());
+}
+
+// returns a new dictionary with the statistics of the histogram, in seconds
+static PyObject* pythonizeLatencyHistogram(const R2LatencyHistogram& h){
+    return Py_BuildValue("{s:K,s:d,s:d,s:d,s:d}",
+        "count", (unsigned long long)h.count,
+        "mean", h.mean()*1e-9,
+        "p50", double(h.percentile(0.5))*1e-9,
+        "p99", double(h.percentile(0.99))*1e-9,
+        "max", double(h.max)*1e-9);
+}
+
+static PyObject *robosoc2d_simulatorGetProfile(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"clear", NULL};
+    int handle;
+    int clear=0;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "i|p", keywords, &handle, &clear)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+    auto& sim=simulations[handle];
+    const R2Profile& profile=sim->getProfile();
+
+    PyObject *pPhases=PyDict_New();
+    if(pPhases==NULL)
+        return NULL;
+    for(int i=0; i<R2PhaseCount; i++){
+        const R2PhaseStats& stats=profile.phases[i];
+        PyObject *pTicks=pythonizeLatencyHistogram(stats.perTick);
+        if(pTicks==NULL){
+            Py_DECREF(pPhases);
+            return NULL;
+        }
+        PyObject *pStats=Py_BuildValue("{s:d,s:K,s:N}", "time", double(stats.totalNs)*1e-9, "calls", (unsigned long long)stats.calls, "per_tick", pTicks);
+        if((pStats==NULL) || (PyDict_SetItemString(pPhases, getPhaseName(R2Phase(i)), pStats)<0)){
+            Py_XDECREF(pStats);
+            Py_DECREF(pPhases);
+            return NULL;
+        }
+        Py_DECREF(pStats);
+    }
+
+    PyObject *pTicks=pythonizeLatencyHistogram(profile.ticks);
+    if(pTicks==NULL){
+        Py_DECREF(pPhases);
+        return NULL;
+    }
+    PyObject *pProfile=Py_BuildValue("{s:O,s:N,s:N}", "enabled", R2Profile::enabled() ? Py_True : Py_False, "ticks", pTicks, "phases", pPhases);
+    if(clear)
+        sim->clearProfile();
+    return pProfile;
+}
+
+// returns a new dictionary with the decision times (in seconds) of an agent or of a team
+static PyObject* pythonizeAgentLatency(const R2AgentLatency& l){
+    PyObject *pLatency=pythonizeLatencyHistogram(l.latency);
+    if(pLatency==NULL)
+        return NULL;
+    PyObject *pValue=PyFloat_FromDouble(double(l.latency.sum)*1e-9);
+    if((pValue==NULL) || (PyDict_SetItemString(pLatency, "total", pValue)<0)){
+        Py_XDECREF(pValue);
+        Py_DECREF(pLatency);
+        return NULL;
+    }
+    Py_DECREF(pValue);
+    pValue=PyLong_FromUnsignedLongLong((unsigned long long)l.overruns);
+    if((pValue==NULL) || (PyDict_SetItemString(pLatency, "overruns", pValue)<0)){
+        Py_XDECREF(pValue);
+        Py_DECREF(pLatency);
+        return NULL;
+    }
+    Py_DECREF(pValue);
+    return pLatency;
+}
+
+static PyObject *robosoc2d_simulatorGetAgentLatency(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", NULL};
+    int handle;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "i", keywords, &handle)){
+        PyErr_SetString(PyExc_TypeError, "parameter must be an integer");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+    auto& sim=simulations[handle];
+    auto gameState=sim->getGameState();
+
+    PyObject *pTeams[2]{NULL,NULL};
+    PyObject *pPlayers[2]{NULL,NULL};
+    auto cleanup=[&](){
+        for(int t=0; t<=1; t++){
+            Py_XDECREF(pTeams[t]);
+            Py_XDECREF(pPlayers[t]);
+        }
+    };
+    for(int t=0; t<=1; t++){
+        pTeams[t]=pythonizeAgentLatency(sim->getTeamLatency(t));
+        int n=(int)gameState.env.teams[t].size();
+        pPlayers[t]=PyTuple_New(n);
+        if((pTeams[t]==NULL) || (pPlayers[t]==NULL)){
+            cleanup();
+            return NULL;
+        }
+        for(int i=0; i<n; i++){
+            PyObject *pPlayer=pythonizeAgentLatency(sim->getAgentLatency(t, i));
+            if(pPlayer==NULL){
+                cleanup();
+                return NULL;
+            }
+            PyTuple_SET_ITEM(pPlayers[t], i, pPlayer);
+        }
+    }
+
+    return Py_BuildValue("{s:N,s:N,s:N,s:N}", "team1", pTeams[0], "team2", pTeams[1], "players1", pPlayers[0], "players2", pPlayers[1]);
+}
+
+static PyObject *robosoc2d_simulatorSetAgentLatencyTracking(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"enabled", NULL};
+    int handle;
+    int enabled;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ip", keywords, &handle, &enabled)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setAgentLatencyTracking(enabled);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetStepTimeBudget(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"seconds", NULL};
+    int handle;
+    double seconds;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "id", keywords, &handle, &seconds)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setStepTimeBudget(seconds);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetCounterBasedRandom(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"enabled", NULL};
+    int handle;
+    int enabled;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ip", keywords, &handle, &enabled)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setCounterBasedRandom(enabled);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetAgentThreads(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"threads", NULL};
+    int handle;
+    int threads;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ii", keywords, &handle, &threads)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setAgentThreads(threads);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetObservationLatency(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"ticks", NULL};
+    int handle;
+    int ticks;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ii", keywords, &handle, &ticks)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setObservationLatency(ticks);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetCollisionThreads(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"threads", (char *)"min_players", NULL};
+    int handle;
+    int threads;
+    int minPlayers=ParallelCollisionsMinPlayers;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ii|i", keywords, &handle, &threads, &minPlayers)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setCollisionThreads(threads, minPlayers);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetEventDrivenCollisions(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"enabled", NULL};
+    int handle;
+    int enabled;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ip", keywords, &handle, &enabled)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setEventDrivenCollisions(enabled);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetQuiescenceEarlyOut(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"enabled", NULL};
+    int handle;
+    int enabled;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ip", keywords, &handle, &enabled)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setQuiescenceEarlyOut(enabled);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetStateHashing(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"enabled", NULL};
+    int handle;
+    int enabled;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "ip", keywords, &handle, &enabled)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setStateHashing(enabled);
+    Py_RETURN_TRUE;
+}
+
+static PyObject *robosoc2d_simulatorSetStaticRelaxation(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"tolerance", NULL};
+    int handle;
+    double tolerance;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "id", keywords, &handle, &tolerance)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    simulations[handle]->setStaticRelaxation(tolerance);
+    Py_RETURN_TRUE;
+}
+
+// integer: handle of the simulation
+// integer (optional): random seed to be used by the simulation random number generators
+// reference to a robosoc2d.settings object (optional): settings to be used for the new match
+static PyObject *robosoc2d_simulatorReset(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"random_seed", (char *)"game_settings", NULL};
+    int handle;
+    int randomSeed=(int)createChronoRandomSeed();
+    PyObject *pObj=NULL;
+    R2EnvSettings cSettings;
+
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "i|iO", keywords, &handle, &randomSeed, &pObj)){
+        PyErr_SetString(PyExc_TypeError, "wrong parameters");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    if((pObj != NULL) && (pObj != Py_None)){
+        if(pObj->ob_type != &R2SettingsType){
+            PyErr_SetString(PyExc_TypeError, "wrong type for settings parameter");
+            return NULL;
+        }
+        fillR2Settings(cSettings, *((R2SettingsObject*)pObj));
+        simulations[handle]->reset((unsigned int)randomSeed, cSettings);
+    }
+    else{
+        simulations[handle]->reset((unsigned int)randomSeed);
+    }
+
+    Py_RETURN_TRUE;
+}
+
 static PyObject *robosoc2d_simulatorDelete(PyObject *self, PyObject *args, PyObject *keywds){
     static char *keywords[] = {(char *)"handle", NULL};
     int handle;
@@ -1271,6 +1709,308 @@ static PyObject *robosoc2d_simulatorSaveActionsHistory(PyObject *self, PyObject
     return  PyBool_FromLong((long)simulations[handle]->saveActionsHistory(string(filename)));
 }
 
+static PyObject *robosoc2d_simulatorSavePhysicsCounters(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"filename", NULL};
+    int handle;
+    const char* filename;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "is", keywords, &handle, &filename)){
+        PyErr_SetString(PyExc_TypeError, "wrong arguments");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    return  PyBool_FromLong((long)simulations[handle]->savePhysicsCounters(string(filename)));
+}
+
+static PyObject *robosoc2d_simulatorGetPhysicsCounters(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", NULL};
+    int handle;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "i", keywords, &handle)){
+        PyErr_SetString(PyExc_TypeError, "parameter must be an integer");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+    const R2PhysicsCounters& physics=simulations[handle]->getPhysicsCounters();
+
+    PyObject *pSubSteps=PyTuple_New(MaxCollisionInsideTickLoop+1);
+    if(pSubSteps==NULL)
+        return NULL;
+    for(int i=0; i<=MaxCollisionInsideTickLoop; i++)
+        PyTuple_SET_ITEM(pSubSteps, i, PyLong_FromLong(physics.subSteps[i]));
+
+    return Py_BuildValue("{s:N,s:{s:i,s:i,s:i,s:i},s:{s:i,s:i,s:i,s:i,s:i},s:{s:i,s:i,s:i,s:i},s:i,s:i,s:i,s:i}",
+        "sub_steps", pSubSteps,
+        "collisions",
+            "pole_ball", physics.collisions[int(R2CollisionType::PoleBall)],
+            "pole_player", physics.collisions[int(R2CollisionType::PolePlayer)],
+            "ball_player", physics.collisions[int(R2CollisionType::BallPlayer)],
+            "player_player", physics.collisions[int(R2CollisionType::PlayerPlayer)],
+        "cap_hits",
+            "collisions_loop", physics.collisionsLoopCapHits,
+            "ball_inside_players", physics.ballInsidePlayersCapHits,
+            "static_ball", physics.staticBallCapHits,
+            "static_players", physics.staticPlayersCapHits,
+            "static_pole_players", physics.staticPolePlayersCapHits,
+        "activations",
+            "ball_inside_players", physics.ballInsidePlayersActivations,
+            "static_ball", physics.staticBallActivations,
+            "static_players", physics.staticPlayersActivations,
+            "static_pole_players", physics.staticPolePlayersActivations,
+        "anti_bounces", physics.antiBounces,
+        "ball_player_blacklists", physics.ballPlayerBlacklists,
+        "static_players_tolerance_stops", physics.staticPlayersToleranceStops,
+        "quiet_ticks", physics.quietTicks);
+}
+
+static PyObject *robosoc2d_simulatorGetStateHashes(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", NULL};
+    int handle;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "i", keywords, &handle)){
+        PyErr_SetString(PyExc_TypeError, "parameter must be an integer");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+    auto& sim=simulations[handle];
+    const std::vector<uint64_t>& hashes=sim->getStateHashes();
+    int ticks=std::min(sim->getEvents().ticks, int(hashes.size())-1);
+
+    PyObject *pHashes=PyTuple_New(ticks+1);
+    if(pHashes==NULL)
+        return NULL;
+    for(int t=0; t<=ticks; t++){
+        PyObject *pHash=PyLong_FromUnsignedLongLong((unsigned long long)hashes[t]);
+        if(pHash==NULL){
+            Py_DECREF(pHashes);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(pHashes, t, pHash);
+    }
+    return Py_BuildValue("{s:K,s:N}", "digest", (unsigned long long)sim->getStateDigest(), "hashes", pHashes);
+}
+
+static PyObject *robosoc2d_simulatorSaveStateHashes(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", (char *)"filename", NULL};
+    int handle;
+    const char* filename;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "is", keywords, &handle, &filename)){
+        PyErr_SetString(PyExc_TypeError, "wrong arguments");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    return  PyBool_FromLong((long)simulations[handle]->saveStateHashes(string(filename)));
+}
+
+// flat, C-contiguous memory exported through the buffer protocol.
+// It is used to hand over bulk data (e.g. the history) so that numpy.asarray() can wrap it without copying
+struct R2ArrayObject {
+    PyObject_HEAD
+    char *data;
+    const char *format;
+    Py_ssize_t itemSize;
+    Py_ssize_t len;
+    int ndim;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+};
+
+static void
+R2ArrayType_dealloc(R2ArrayObject *obj)
+{
+    PyMem_Free(obj->data);
+    Py_TYPE(obj)->tp_free((PyObject *) obj);
+}
+
+static int R2Array_getbuffer(R2ArrayObject *obj, Py_buffer *view, int flags){
+    view->obj = (PyObject*)obj;
+    Py_INCREF(obj);
+    view->buf = obj->data;
+    view->len = obj->len;
+    view->readonly = 0;
+    view->itemsize = obj->itemSize;
+    view->format = (flags & PyBUF_FORMAT) ? (char*)obj->format : NULL;
+    view->ndim = obj->ndim;
+    view->shape = (flags & PyBUF_ND) ? obj->shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? obj->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs R2Array_as_buffer = {
+    (getbufferproc) R2Array_getbuffer,
+    NULL
+};
+
+static PyTypeObject R2ArrayType =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+// returns a memoryview of a new zero-filled array with the given shape, and sets data to point to its memory.
+// format is a struct module format character: "d" for double, "i" for int, "?" for bool
+template <typename T>
+static PyObject* newArrayView(const char *format, std::initializer_list<Py_ssize_t> shape, T** data){
+    R2ArrayObject *array=PyObject_New(R2ArrayObject, &R2ArrayType);
+    if(array==NULL)
+        return NULL;
+
+    array->data=NULL;
+    array->format=format;
+    array->itemSize=sizeof(T);
+    array->ndim=(int)shape.size();
+    Py_ssize_t count=1;
+    int d=0;
+    for(auto n: shape){
+        array->shape[d++]=n;
+        count*=n;
+    }
+    array->len=count*array->itemSize;
+    Py_ssize_t stride=array->itemSize;
+    for(d=array->ndim-1; d>=0; d--){
+        array->strides[d]=stride;
+        stride*=array->shape[d];
+    }
+    array->data=(char*)PyMem_Calloc( (array->len>0) ? array->len : 1, 1);
+    if(array->data==NULL){
+        Py_DECREF(array);
+        return PyErr_NoMemory();
+    }
+    *data=(T*)array->data;
+
+    PyObject *view=PyMemoryView_FromObject((PyObject*)array);
+    Py_DECREF(array);   // the memoryview keeps it alive
+    return view;
+}
+
+// returns a dictionary of memoryviews (that numpy.asarray() turns into arrays without copying) containing the whole recorded history:
+// T states and T_A actions, with N=n_players1+n_players2. Players of first team come first.
+static PyObject *robosoc2d_simulatorGetHistory(PyObject *self, PyObject *args, PyObject *keywds){
+    static char *keywords[] = {(char *)"handle", NULL};
+    int handle;
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "i", keywords, &handle)){
+        PyErr_SetString(PyExc_TypeError, "parameter must be an integer");
+        return NULL;
+    }
+
+    if(simulations.count(handle) == 0){
+        PyErr_SetString(R2Error, "simulation handle not existing");
+        return NULL;
+    }
+
+    auto& sim=simulations[handle];
+    const R2History& history=sim->getHistory();
+    R2GameState gameState=sim->getGameState();
+    const Py_ssize_t nPlayers[2]{(Py_ssize_t)gameState.env.teams[0].size(), (Py_ssize_t)gameState.env.teams[1].size()};
+    const Py_ssize_t n=nPlayers[0]+nPlayers[1];
+    const Py_ssize_t nTicks=sim->getHistoryStatesLength();
+    const Py_ssize_t nActionTicks=sim->getHistoryActionsLength();
+
+    PyObject *dict=PyDict_New();
+    if(dict==NULL)
+        return NULL;
+
+    auto addItem=[&](const char* key, PyObject* value){
+        if(value==NULL)
+            return false;
+        int r=PyDict_SetItemString(dict, key, value);
+        Py_DECREF(value);
+        return (r==0);
+    };
+
+    int *tick, *score1, *score2, *state, *ballCatched, *actionOrder;
+    bool *lastTouchedTeam2, *ballCatchedTeam2, *halftimePassed;
+    double *startingTeamMaxRange, *ball, *players, *actions;
+
+    if( !addItem("n_players1", PyLong_FromSsize_t(nPlayers[0])) ||
+        !addItem("n_players2", PyLong_FromSsize_t(nPlayers[1])) ||
+        !addItem("tick", newArrayView("i", {nTicks}, &tick)) ||
+        !addItem("score1", newArrayView("i", {nTicks}, &score1)) ||
+        !addItem("score2", newArrayView("i", {nTicks}, &score2)) ||
+        !addItem("state", newArrayView("i", {nTicks}, &state)) ||
+        !addItem("ball", newArrayView("d", {nTicks, 4}, &ball)) ||
+        !addItem("players", newArrayView("d", {nTicks, n, 5}, &players)) ||
+        !addItem("last_touched_team2", newArrayView("?", {nTicks}, &lastTouchedTeam2)) ||
+        !addItem("starting_team_max_range", newArrayView("d", {nTicks}, &startingTeamMaxRange)) ||
+        !addItem("ball_catched", newArrayView("i", {nTicks}, &ballCatched)) ||
+        !addItem("ball_catched_team2", newArrayView("?", {nTicks}, &ballCatchedTeam2)) ||
+        !addItem("halftime_passed", newArrayView("?", {nTicks}, &halftimePassed)) ||
+        !addItem("actions", newArrayView("d", {nActionTicks, n, 4}, &actions)) ||
+        !addItem("action_order", newArrayView("i", {nActionTicks, n}, &actionOrder)) ){
+        Py_DECREF(dict);
+        return NULL;
+    }
+
+    for(Py_ssize_t t=0; t<nTicks; t++){
+        auto& e=history.envs[t];
+        tick[t]=e.tick;
+        score1[t]=e.score1;
+        score2[t]=e.score2;
+        state[t]=static_cast<int>(e.state);
+        double *b=ball+t*4;
+        b[0]=e.ball.pos.x;
+        b[1]=e.ball.pos.y;
+        b[2]=e.ball.velocity.x;
+        b[3]=e.ball.velocity.y;
+        lastTouchedTeam2[t]=e.lastTouchedTeam2;
+        startingTeamMaxRange[t]=e.startingTeamMaxRange;
+        ballCatched[t]=e.ballCatched;
+        ballCatchedTeam2[t]=e.ballCatchedTeam2;
+        halftimePassed[t]=e.halftimePassed;
+
+        double *p=players+t*n*5;
+        for(int w=0; w<=1; w++){
+            if((Py_ssize_t)e.teams[w].size()!=nPlayers[w]){ // tick skipped by simulator_set_environment(): left zeroed
+                p+=nPlayers[w]*5;
+                continue;
+            }
+            for(auto& pl: e.teams[w]){
+                p[0]=pl.pos.x;
+                p[1]=pl.pos.y;
+                p[2]=pl.velocity.x;
+                p[3]=pl.velocity.y;
+                p[4]=pl.direction;
+                p+=5;
+            }
+        }
+    }
+
+    // actions are stored by player index, action_order keeps the order in which they were processed
+    for(Py_ssize_t t=0; t<nActionTicks; t++){
+        auto& records=history.actions[t];
+        for(Py_ssize_t i=0; i<n && i<(Py_ssize_t)records.size(); i++){
+            auto& r=records[i];
+            Py_ssize_t index= r.team*nPlayers[0] + r.player;
+            if((index<0) || (index>=n))
+                continue;
+            double *a=actions+(t*n+index)*4;
+            a[0]=static_cast<int>(r.action.action);
+            a[1]=r.action.data[0];
+            a[2]=r.action.data[1];
+            a[3]=r.action.data[2];
+            actionOrder[t*n+i]=(int)index;
+        }
+    }
+
+    return dict;
+}
+
 static PyObject *robosoc2d_simulatorDeleteAll(PyObject *self, PyObject *args){
     simulations.clear();
     Py_INCREF(Py_None);
@@ -1368,6 +2108,21 @@ static PyMethodDef Robosoc2dMethods[] = {
     {"build_simulator", (PyCFunction)robosoc2d_buildSimulator, METH_VARARGS|METH_KEYWORDS, "build_simulator(team1, team2, team1name, team2name, random_seed, game_settings)\n\nIt creates a simulator and returns an integer that represents an handle to it. First and second parameters are mandatory and must be sequences of players, one sequence per team. It is possible to have a different number of players in each team. The other parameters are not mandatory. The third and fourth parameters are strings containing team names. Fifth parameter is an integer containing the random seed to be used to initialize the random engine (if this parameter is missing, a random seed will be generated depending on current time). Sixth parameter is a settings object in case you want to choose you own settings. (a player is an object that implements the method step(self, env, pitch, settings, team1, team2) that receives the information about the game and returns the choosen action as a tuple composed by one integer and three floats) " },
     {"build_simpleplayer_simulator", (PyCFunction)robosoc2d_buildSimplePlayerSimulator, METH_VARARGS|METH_KEYWORDS, "build_simpleplayer_simulator (team1, how_manysimpleplayers_team1, team2, how_manysimpleplayers_team1, team1name, team2name, random_seed, game_settings)\n\nIt creates a simulator and returns an integer that represents an handle to it. For each team it is possible to use the built-in class SimplePlayer for some players. The user may decide how many SimplePlayer agent each team may have: the first players of the team will be the SimplePlayers ones (if any), and the subsequent players will be the ones inserted in the team sequences (that may possibly be empty). Since the SimplePlayers will be the first players of the team, and since the first player plays in the goalkeeper role, if a team has at least a SimplePlayer, it means the the goalkeeper will be certainly a SimplePlater. Parameters 1-4 are mandatory. First parameter must be a sequence containing the players objects for the first team, and second parameter is a boolean determining how many SimplePlayers have to be added at the beginning of the team. Third and fourth parameters are the same for the second team. It is possible to have a different number of players in each team. The other parameters are not mandatory. The fifth and sixth parameters are strings containing team names. Seventh parameter is an integer containing the random seed to be used to initialize the random engine (if this parameter is missing, a random seed will be generated depending on current time). Eighth parameter is a settings object in case you want to choose you own settings.(a player is an object that implements the method step(self, env, pitch, settings, team1, team2) that receives the information about the game and returns the choosen action as a tuple composed by one integer and three floats) " },
     {"simulator_step_if_playing", (PyCFunction)robosoc2d_simulatorStepIfPlaying, METH_VARARGS|METH_KEYWORDS, "simulator_step_if_playing (handle)\n\nIt runs a step of the simulation, if the simulation is still playable and not terminated. It accepts only one parameter: an integer that is an handle to the simulation. It returns a boolean that is false if the game was still playable." },
+    {"simulator_step_n", (PyCFunction)robosoc2d_simulatorStepN, METH_VARARGS|METH_KEYWORDS, "simulator_step_n (handle, k, actions)\n\nIt runs up to k steps of the simulation (less if the game ends) with a single call. The first parameter is an integer that is an handle to the simulation, the second is the integer k. The optional parameter actions is a sequence containing, for each player (first team players followed by second team players), either an action tuple or None (ValueError is raised if its length is not the number of players): players with an action tuple do not have their step() method called and repeat that action at each of the k steps (whatever the state of the game is), while players with None choose their actions as usual. It returns a tuple containing: a boolean that is False if the game is terminated, a dictionary with the events happened during the steps (keys: 'ticks', 'goals1', 'goals2', 'ball_out', 'kicks1', 'kicks2', 'touches1', 'touches2', 'catches1', 'catches2'), and the final game state in the same format of simulator_get_game_state()." },
+    {"simulator_get_events", (PyCFunction)robosoc2d_simulatorGetEvents, METH_VARARGS|METH_KEYWORDS, "simulator_get_events (handle)\n\nIt returns a dictionary with the events happened since the beginning of the game, in the same format used by simulator_step_n(). It accepts only one parameter: an integer that is an handle to the simulation." },
+    {"simulator_reset", (PyCFunction)robosoc2d_simulatorReset, METH_VARARGS|METH_KEYWORDS, "simulator_reset (handle, random_seed, game_settings)\n\nIt brings the simulation back to the beginning of a new match, reusing the memory already allocated, so that it is cheaper than deleting the simulator and building a new one. The first parameter is an integer that is an handle to the simulation. The second, optional, parameter is an integer containing the new random seed (if missing, a random seed will be generated depending on current time). The third, optional, parameter is a settings object to be used for the new match (if missing, the current settings are kept). Players are kept: the built-in SimplePlayer agents are brought back to their initial state, while if a Python player object has an internal state, it is up to it to reset it. It returns True." },
+    {"simulator_get_profile", (PyCFunction)robosoc2d_simulatorGetProfile, METH_VARARGS|METH_KEYWORDS, "simulator_get_profile (handle, clear)\n\nIt returns a dictionary with the time spent by the simulator in each of its phases. Timing is active only if the module has been compiled with the macro _R2S_PROFILE (i.e. setting the environment variable R2S_PROFILE before running setup.py), otherwise all values are zero: the key 'enabled' tells which is the case. The key 'ticks' contains the statistics of the duration of the steps: a dictionary with keys 'count', 'mean', 'p50', 'p99', 'max' (times are in seconds, percentiles have 12.5% resolution). The key 'phases' contains a dictionary with an entry for each phase ('pre_state', 'players_act', 'players_agents', 'players_process_step', 'manage_collisions', 'manage_static_players_collisions', 'check_state', 'decay_speed', 'history'), each of which is a dictionary with keys 'time' (total seconds), 'calls', and 'per_tick' (the statistics of the time spent in the phase in the ticks in which it has been run, in the same format of 'ticks'). The first parameter is an integer that is an handle to the simulation, the second, optional, parameter is a boolean: if True the statistics are set to zero after being returned." },
+    {"simulator_get_agent_latency", (PyCFunction)robosoc2d_simulatorGetAgentLatency, METH_VARARGS|METH_KEYWORDS, "simulator_get_agent_latency (handle)\n\nIt returns a dictionary with the time taken by the players step() methods since the beginning of the match. The keys 'team1' and 'team2' contain the statistics of the whole teams, while 'players1' and 'players2' are tuples containing the statistics of each player. The statistics are dictionaries with keys 'count' (number of steps), 'total', 'mean', 'p50', 'p99', 'max' (in seconds, percentiles have 12.5% resolution) and 'overruns' (the steps that took longer than the step time budget). The times are recorded only while enabled with simulator_set_agent_latency_tracking, otherwise only the overruns are counted. It accepts only one parameter: an integer that is an handle to the simulation." },
+    {"simulator_set_agent_latency_tracking", (PyCFunction)robosoc2d_simulatorSetAgentLatencyTracking, METH_VARARGS|METH_KEYWORDS, "simulator_set_agent_latency_tracking (handle, enabled)\n\nIf enabled, the time taken by each call of the players step() methods is recorded (see simulator_get_agent_latency). It is disabled by default, so that the clock is not read at each call, and it does not change the game. The first parameter is an integer that is an handle to the simulation, the second one is a boolean. It returns True." },
+    {"simulator_set_step_time_budget", (PyCFunction)robosoc2d_simulatorSetStepTimeBudget, METH_VARARGS|METH_KEYWORDS, "simulator_set_step_time_budget (handle, seconds)\n\nIt sets the maximum time that a player step() method may take: if it takes longer, the player's action is replaced by ACTION_NOOP and the overrun is recorded (see simulator_get_agent_latency). With a budget the game is not reproducible anymore, since it depends on the timing. The budget does not interrupt step(): the method always runs to the end, and only then its action is discarded. A value of 0.0 removes the budget (that is the default). The first parameter is an integer that is an handle to the simulation, the second one is a float with the budget in seconds. It returns True." },
+    {"simulator_set_counter_based_random", (PyCFunction)robosoc2d_simulatorSetCounterBasedRandom, METH_VARARGS|METH_KEYWORDS, "simulator_set_counter_based_random (handle, enabled)\n\nIt chooses the random number generator of the simulation. By default numbers are drawn in sequence from a single generator. If enabled, each number is computed from seed, tick, purpose (e.g. kick noise) and player with a counter-based generator (Philox), so it does not depend on the order of evaluation nor on the C++ standard library, and normal numbers come from a faster ziggurat sampler. Matches are reproducible in both cases, but different. It should be called before the beginning of the match, and it is kept by simulator_reset. The first parameter is an integer that is an handle to the simulation, the second one is a boolean. It returns True." },
+    {"simulator_set_agent_threads", (PyCFunction)robosoc2d_simulatorSetAgentThreads, METH_VARARGS|METH_KEYWORDS, "simulator_set_agent_threads (handle, threads)\n\nIt sets how many threads run the built-in SimplePlayer agents: when all the players receive the same game state, their step() is computed concurrently, then the actions are applied one by one in the usual order, so the game is the same as with a single thread. Python players are always called one at a time. A value of 0 or 1 restores the default single thread. The first parameter is an integer that is an handle to the simulation, the second one is an integer. It returns True." },
+    {"simulator_set_observation_latency", (PyCFunction)robosoc2d_simulatorSetObservationLatency, METH_VARARGS|METH_KEYWORDS, "simulator_set_observation_latency (handle, ticks)\n\nIt makes the players act on a stale game state: the action of each tick is chosen on the game state of the given number of ticks before, in every phase of the game, and during the first ticks of the match players do nothing. The built-in SimplePlayer agents decide on a background thread, while the simulator computes the physics of the following ticks. Python players are called by the simulator thread with the same delayed state. It is kept by simulator_reset, and a value of 0 (the default) restores the current game state. The first parameter is an integer that is an handle to the simulation, the second one is an integer. It returns True." },
+    {"simulator_set_collision_threads", (PyCFunction)robosoc2d_simulatorSetCollisionThreads, METH_VARARGS|METH_KEYWORDS, "simulator_set_collision_threads (handle, threads, min_players)\n\nIt sets how many threads search the earliest collisions among ball and players, when there are at least min_players players on the pitch (both teams). The game is the same as with a single thread. It is useful only with very large teams. A value of 0 or 1 restores the default single thread. The first parameter is an integer that is an handle to the simulation, the second one is an integer, the third one is optional and it is an integer (64 if missing). It returns True." },
+    {"simulator_set_event_driven_collisions", (PyCFunction)robosoc2d_simulatorSetEventDrivenCollisions, METH_VARARGS|METH_KEYWORDS, "simulator_set_event_driven_collisions (handle, enabled)\n\nIt chooses the collision solver. By default, after each collision handled during a tick, all the times of impact are searched again. If enabled, they are kept in a priority queue and only those of the objects whose motion changed are searched again, which is faster in crowded situations. The rules are the same, but matches are slightly different from the ones of the default solver (they are reproducible with both). The first parameter is an integer that is an handle to the simulation, the second one is a boolean. It returns True." },
+    {"simulator_set_quiescence_early_out", (PyCFunction)robosoc2d_simulatorSetQuiescenceEarlyOut, METH_VARARGS|METH_KEYWORDS, "simulator_set_quiescence_early_out (handle, enabled)\n\nBy default, at each tick the simulator first checks which objects could meet, and it skips the search of the collisions that cannot happen (in most ticks, all of them). The match is the same when disabled, so it is useful only to measure the gain. The first parameter is an integer that is an handle to the simulation, the second one is a boolean. It returns True." },
+    {"simulator_set_static_relaxation", (PyCFunction)robosoc2d_simulatorSetStaticRelaxation, METH_VARARGS|METH_KEYWORDS, "simulator_set_static_relaxation (handle, tolerance)\n\nWhen the game is not active, overlapping players are pushed apart in repeated passes until no overlap is deeper than tolerance, or after 10 passes. The default tolerance (1e-9, or 1e-5 in single precision) leaves only the overlaps due to rounding errors, which saves most of the passes in crowded set pieces; with tolerance 0 they run until no overlap is left, and the match is not the same. The first parameter is an integer that is an handle to the simulation, the second one is a float. It returns True." },
+    {"simulator_set_state_hashing", (PyCFunction)robosoc2d_simulatorSetStateHashing, METH_VARARGS|METH_KEYWORDS, "simulator_set_state_hashing (handle, enabled)\n\nIf enabled (the default), a 64 bit hash of the game state is computed at the end of every tick (see simulator_get_state_hashes). The whole state is hashed each time, which costs about 50 ns per tick with 4 players per team and 120 ns with 11, below 1% of a tick. It should be called before the beginning of the match, and it is kept by simulator_reset. The first parameter is an integer that is an handle to the simulation, the second one is a boolean. It returns True." },
     {"simulator_play_game", (PyCFunction)robosoc2d_simulatorPlayGame, METH_VARARGS|METH_KEYWORDS, "simulator_play_game (handle)\n\nIt runs all the step of the simulation till the end. It accepts only one parameter: an integer that is an handle to the simulation. It returns a boolean containing True if the game was played, throws an exception otherwise." },
     {"simulator_delete", (PyCFunction)robosoc2d_simulatorDelete, METH_VARARGS|METH_KEYWORDS, "simulator_delete (handle)\n\nIt deletes a simulator. It accepts only one parameter: an integer that is an handle to the simulation. It returns a boolean containing True if the simulation has been deleted, False otherwise." },
     {"simulator_delete_all", (PyCFunction)robosoc2d_simulatorDeleteAll, METH_NOARGS, "simulator_delete_all ()\n\nIt deletes all simulators. No parameters. It returns None" },
@@ -1378,6 +2133,11 @@ static PyMethodDef Robosoc2dMethods[] = {
     {"simulator_get_team_names", (PyCFunction)robosoc2d_simulatorGetTeamNames, METH_VARARGS|METH_KEYWORDS,"simulator_get_team_names (handle)\n\nIt returns the team names as a tuple containing two strings. It accepts only one parameter: an integer that is an handle to the simulation."},
     {"simulator_save_state_history", (PyCFunction)robosoc2d_simulatorSaveStateHistory, METH_VARARGS|METH_KEYWORDS,"simulator_save_state_history (handle, filename)\n\nIt saves the state history of the simulator. The first parameter is an integer that is an handle to the simulation. The second parameter is the file name. It returns a boolean representing success (True) or failure (False)."},
     {"simulator_save_actions_history", (PyCFunction)robosoc2d_simulatorSaveActionsHistory, METH_VARARGS|METH_KEYWORDS,"simulator_save_actions_history (handle, filename)\n\nIt saves the actions history of the simulator. The first parameter is an integer that is an handle to the simulation. The second parameter is the file name. It returns a boolean representing success (True) or failure (False)."},
+    {"simulator_save_physics_counters", (PyCFunction)robosoc2d_simulatorSavePhysicsCounters, METH_VARARGS|METH_KEYWORDS,"simulator_save_physics_counters (handle, filename)\n\nIt saves the physics counters of the simulator (see simulator_get_physics_counters) in a text file, one counter per line. The first parameter is an integer that is an handle to the simulation. The second parameter is the file name. It returns a boolean representing success (True) or failure (False)."},
+    {"simulator_get_state_hashes", (PyCFunction)robosoc2d_simulatorGetStateHashes, METH_VARARGS|METH_KEYWORDS,"simulator_get_state_hashes (handle)\n\nIt returns a dictionary with the hashes of the game state, computed at the end of every tick unless disabled with simulator_set_state_hashing (then 'digest' is 0 and 'hashes' is empty): 'digest' is an integer combining all the hashes since the beginning of the match, 'hashes' is a tuple whose element t is the hash of the state at tick t (0 for tick 0). Two runs producing the same trajectory have the same hashes on every machine, so the first differing element shows where two runs diverged. It accepts only one parameter: an integer that is an handle to the simulation."},
+    {"simulator_save_state_hashes", (PyCFunction)robosoc2d_simulatorSaveStateHashes, METH_VARARGS|METH_KEYWORDS,"simulator_save_state_hashes (handle, filename)\n\nIt saves the hashes of the game state (see simulator_get_state_hashes) in a text file: the version, the digest, then a line per tick with tick and hash in hexadecimal. If hashing is disabled no file is written and it returns False. The first parameter is an integer that is an handle to the simulation. The second parameter is the file name. It returns a boolean representing success (True) or failure (False)."},
+    {"simulator_get_physics_counters", (PyCFunction)robosoc2d_simulatorGetPhysicsCounters, METH_VARARGS|METH_KEYWORDS,"simulator_get_physics_counters (handle)\n\nIt returns a dictionary with counters of the work done by the collision solvers since the beginning of the match. 'sub_steps' is a tuple whose n-th element is the number of ticks in which the collision loop iterated n times (the last element includes the ticks in which the loop reached its cap). 'collisions' counts the solved collisions by type ('pole_ball', 'pole_player', 'ball_player', 'player_player'). 'cap_hits' counts how many times each solver ('collisions_loop', 'ball_inside_players', 'static_ball', 'static_players', 'static_pole_players') stopped because of its iteration limit with collisions still to solve. 'activations' counts how many times each of the last four solvers had to separate objects. 'anti_bounces' counts how many times the ball bouncing back and forth between two players has been stopped, and 'ball_player_blacklists' how many ball-player collisions have been ignored for the rest of the tick because of null relative velocity. 'static_players_tolerance_stops' counts how many times the separation of the static players stopped with only overlaps not deeper than the tolerance left (see simulator_set_static_relaxation). It accepts only one parameter: an integer that is an handle to the simulation."},
+    {"simulator_get_history", (PyCFunction)robosoc2d_simulatorGetHistory, METH_VARARGS|METH_KEYWORDS,"simulator_get_history (handle)\n\nIt returns the whole history recorded so far, without passing through files. It accepts only one parameter: an integer that is an handle to the simulation. It returns a dictionary of memoryviews, that can be turned into numpy arrays without copying data with numpy.asarray(). With T recorded ticks, T_A recorded actions ticks and N=n_players1+n_players2 players (first team players come first) the keys are: 'ball' (T,4) with x, y, velocity_x, velocity_y; 'players' (T,N,5) with x, y, velocity_x, velocity_y, direction; the columns 'tick', 'score1', 'score2', 'state', 'last_touched_team2', 'starting_team_max_range', 'ball_catched', 'ball_catched_team2', 'halftime_passed', each of shape (T); 'actions' (T_A,N,4) with the action type and its three float values for each player; 'action_order' (T_A,N) with the indexes of the players in the order in which their actions have been processed; and the integers 'n_players1', 'n_players2'."},
     {"simulator_set_environment", (PyCFunction)robosoc2d_set_environment, METH_VARARGS|METH_KEYWORDS, "simulator_set_environment(handle, tick, score1, score2, state, ball_x, ball_y, ball_velocity_x, ball_velocity_y, team1, team2, last_touched_team2, ball_catched, ball_catched_team2) \n\n It sets the game configuration, making possible to decide things like players' and ball's positions, velocities and so on. The first parameter is an integer that is an handle to the simulation. The second parameter is an integer that represents the time tick. Third and fourth parameters are integers representing current score for the two teams. The fith parameter is an integer indicating the state of the game, to be picked up among the constants robosoc2d.STATE_* , for instance robosoc2d.STATE_PLAY . Next 4 parameters are floats containing ball position and velocity. Then the parameter team1 is a sequence containing objects of type robosoc2d.player_info that specify position, velocity and direction of the players of the first team. The parameter team2 is the same for the second team. Then there are 3 optional parameters: last_touched_team2 is a bool that indicates if the last team that touched the ball was team2. The integer ball_catched indicates if the ball is currently owned by a gall keeper: if >0 the ball is catched and only the goalkeeper can kick it and the ball moves with him, thenumber actually indicates for how many ticks the ball is still allowed to be possessed by the goalkeeper. The boolean ball_catched_team2 should be true if the goalkeeper that owns the ball is the one of second team."},
     {"remainder", (PyCFunction)robosoc2d_remainder, METH_VARARGS|METH_KEYWORDS,"remainder (dividend, divisor)\n\nMath remainder function following IEEE754 specification. Helper method for people using python prior to 3.7 because python<3.7 doesn't have true IEEE754 remainder (numpy neither). This should be equivalent to python 3.7: math.remainder(dividend, divisor)"},
     
@@ -1408,6 +2168,21 @@ get_seed_by_current_time () \n\
 build_simulator (team1, team2, team1name, team2name, random_seed, game_settings) \n\
 build_simpleplayer_simulator (team1, how_manysimpleplayers_team1, team2, how_manysimpleplayers_team1, team1name, team2name, random_seed, game_settings) \n\
 simulator_step_if_playing (handle) \n\
+simulator_step_n (handle, k, actions) \n\
+simulator_get_events (handle) \n\
+simulator_reset (handle, random_seed, game_settings) \n\
+simulator_get_profile (handle, clear) \n\
+simulator_get_agent_latency (handle) \n\
+simulator_set_agent_latency_tracking (handle, enabled) \n\
+simulator_set_step_time_budget (handle, seconds) \n\
+simulator_set_counter_based_random (handle, enabled) \n\
+simulator_set_agent_threads (handle, threads) \n\
+simulator_set_observation_latency (handle, ticks) \n\
+simulator_set_collision_threads (handle, threads, min_players) \n\
+simulator_set_event_driven_collisions (handle, enabled) \n\
+simulator_set_quiescence_early_out (handle, enabled) \n\
+simulator_set_static_relaxation (handle, tolerance) \n\
+simulator_set_state_hashing (handle, enabled) \n\
 simulator_play_game (handle) \n\
 simulator_delete (handle) \n\
 simulator_delete_all () \n\
@@ -1418,6 +2193,11 @@ simulator_get_random_seed (handle) \n\
 simulator_get_team_names (handle) \n\
 simulator_save_state_history (handle, filename) \n\
 simulator_save_actions_history (handle, filename) \n\
+simulator_get_history (handle) \n\
+simulator_save_physics_counters (handle, filename) \n\
+simulator_get_physics_counters (handle) \n\
+simulator_get_state_hashes (handle) \n\
+simulator_save_state_hashes (handle, filename) \n\
 remainder (dividend, divisor) \n\
 \n\
 Constants: \n\
@@ -1503,6 +2283,14 @@ PyInit_robosoc2d(void) {
     R2PlayerInfoType.tp_repr = (reprfunc) R2PlayerInfoObject_repr;
     R2PlayerInfoType.tp_dealloc = (destructor) R2PlayerInfoType_dealloc;    //unnecessary
 
+    R2ArrayType.tp_name = "robosoc2d.array";
+    R2ArrayType.tp_basicsize = sizeof(R2ArrayObject);
+    R2ArrayType.tp_itemsize = 0;
+    R2ArrayType.tp_flags = Py_TPFLAGS_DEFAULT;
+    R2ArrayType.tp_doc = "Memory exported through the buffer protocol. Use memoryview() or numpy.asarray() on it.";
+    R2ArrayType.tp_as_buffer = &R2Array_as_buffer;
+    R2ArrayType.tp_dealloc = (destructor) R2ArrayType_dealloc;
+
 
     if (PyType_Ready(&R2SettingsType) < 0)
     {
@@ -1524,6 +2312,11 @@ PyInit_robosoc2d(void) {
         return NULL;
     }
 
+    if (PyType_Ready(&R2ArrayType) < 0)
+    {
+        return NULL;
+    }
+
     PyObject* m = PyModule_Create(&robosoc2dmodule);
     if (m == NULL) {
         return NULL;
@@ -1,7 +1,13 @@
 import os
 from setuptools import setup, Extension
 
-module = Extension('robosoc2d', sources=['robosoc2dmodule.cpp'], language='c++', extra_compile_args=['-std=c++17', '-v']) #python version
+# set the environment variable R2S_PROFILE to compile the timers of the simulator phases (see simulator_get_profile)
+macros = [('_R2S_PROFILE', None)] if os.environ.get('R2S_PROFILE') else []
+# set the environment variable R2S_FLOAT to compile the simulator in single precision (matches are different from the default ones)
+if os.environ.get('R2S_FLOAT'):
+    macros.append(('_R2S_FLOAT', None))
+
+module = Extension('robosoc2d', sources=['robosoc2dmodule.cpp'], language='c++', extra_compile_args=['-std=c++17', '-v'], define_macros=macros) #python version
 #module = Extension('robosoc2d', sources=['robosoc2dmodule.cpp'], language='c++', extra_compile_args=['/std:c++17']) # windows version
 
 with open("README.md", "r", encoding="utf-8") as fh:
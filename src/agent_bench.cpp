@@ -0,0 +1,165 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d_agent_bench: cost of the player agents decisions, measured replaying a corpus of recorded game states
+#include "simulator.h"
+#include "simple_player.h"
+#include "alloc_counter.h"  // every allocation of this executable is counted
+
+using namespace std;
+using namespace r2s;
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+// the agents that can be benchmarked: add your own here
+static const map<string, function<shared_ptr<R2Player>(int shirtNumber, int team)>> agentFactories={
+  {"simple", [](int shirtNumber, int team){ return static_pointer_cast<R2Player>(make_shared<SimplePlayer>(shirtNumber, team)); }}
+};
+
+// plays some matches between SimplePlayer teams, capturing the game states received by the agents
+static vector<R2StateSample> captureCorpus(int players, int matches, int everyTicks, unsigned int seed){
+  vector<R2StateSample> samples;
+  for(int m=0; m<matches; m++){
+    auto simulator= buildSimulator<SimplePlayer,SimplePlayer>(players, players, defaultTeam1Name, defaultTeam2Name, seed+m);
+    simulator->captureStates(&samples, everyTicks);
+    simulator->playMatch();
+  }
+  return samples;
+}
+
+static void usage(){
+  cout << "usage: robosoc2d_agent_bench [--corpus FILE | --capture FILE] [--agent NAME] [--repeats N]" << endl;
+  cout << "                             [--players N] [--matches N] [--every N] [--seed N] [--output FILE]" << endl;
+  cout << "  --corpus loads the game states from a file, --capture records them playing matches between SimplePlayer teams and saves them," << endl;
+  cout << "  otherwise they are recorded in memory. Then the states are replayed through the chosen agent, one agent per team and player." << endl;
+  cout << "  agents:";
+  for(auto& f : agentFactories)
+    cout << " " << f.first;
+  cout << endl;
+}
+
+int main(int argc, char** argv)
+{
+  string corpusFile, captureFile, output;
+  string agentName="simple";
+  int repeats=5;
+  int players=4;
+  int matches=1;
+  int everyTicks=10;
+  unsigned int seed=1;
+
+  for(int i=1; i<argc; i++){
+    bool hasValue= (i+1<argc);
+    if((strcmp(argv[i], "--corpus")==0) && hasValue)
+      corpusFile=argv[++i];
+    else if((strcmp(argv[i], "--capture")==0) && hasValue)
+      captureFile=argv[++i];
+    else if((strcmp(argv[i], "--agent")==0) && hasValue)
+      agentName=argv[++i];
+    else if((strcmp(argv[i], "--repeats")==0) && hasValue)
+      repeats=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--players")==0) && hasValue)
+      players=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--matches")==0) && hasValue)
+      matches=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--every")==0) && hasValue)
+      everyTicks=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--seed")==0) && hasValue)
+      seed=stoul(argv[++i]);
+    else if((strcmp(argv[i], "--output")==0) && hasValue)
+      output=argv[++i];
+    else{
+      usage();
+      return 1;
+    }
+  }
+
+  if(agentFactories.count(agentName)==0){
+    usage();
+    return 1;
+  }
+
+  vector<R2StateSample> samples;
+  if(!corpusFile.empty()){
+    samples=loadStateSamples(corpusFile);
+  }
+  else{
+    samples=captureCorpus(players, matches, everyTicks, seed);
+    if(!captureFile.empty() && !saveStateSamples(captureFile, samples)){
+      cerr << "unable to write " << captureFile << endl;
+      return 1;
+    }
+  }
+  if(samples.empty()){
+    cerr << "empty corpus" << endl;
+    return 1;
+  }
+
+  // one agent for each team and shirt number found in the corpus, built before measuring
+  map<pair<int,int>, shared_ptr<R2Player>> agents;
+  for(auto& sample : samples){
+    auto key=make_pair(sample.team, sample.player);
+    if(agents.count(key)==0)
+      agents[key]=agentFactories.at(agentName)(sample.player, sample.team);
+  }
+  vector<R2Player*> sampleAgents;
+  for(auto& sample : samples)
+    sampleAgents.push_back(agents[make_pair(sample.team, sample.player)].get());
+
+  vector<double> nsPerDecision;
+  uint64_t allocs=0, bytes=0;
+  int noOps=0;
+  for(int r=0; r<repeats; r++){
+    uint64_t allocsBefore=R2Allocations::count, bytesBefore=R2Allocations::bytes;
+    noOps=0;
+    auto start=chrono::steady_clock::now();
+    for(size_t i=0; i<samples.size(); i++){
+      R2Action action=sampleAgents[i]->step(samples[i].state);  // the state is passed by value, as the simulator does
+      noOps+= (action.action==R2ActionType::NoOp);
+    }
+    nsPerDecision.push_back(chrono::duration<double, nano>(chrono::steady_clock::now()-start).count()/double(samples.size()));
+    allocs=R2Allocations::count-allocsBefore;
+    bytes=R2Allocations::bytes-bytesBefore;
+  }
+  sort(nsPerDecision.begin(), nsPerDecision.end());
+
+  ostringstream json;
+  json.precision(6);
+  json << "{\n";
+  json << "  \"version\": \"" << R2SVersion << "\",\n";
+#if defined(__OPTIMIZE__) || defined(NDEBUG)
+  json << "  \"optimized\": true,\n";
+#else
+  json << "  \"optimized\": false,\n";
+#endif
+  json << "  \"agent\": \"" << agentName << "\",\n";
+  json << "  \"samples\": " << samples.size() << ",\n";
+  json << "  \"agents\": " << agents.size() << ",\n";
+  json << "  \"repeats\": " << repeats << ",\n";
+  json << "  \"median_ns_per_decision\": " << nsPerDecision[nsPerDecision.size()/2] << ",\n";
+  json << "  \"best_ns_per_decision\": " << nsPerDecision.front() << ",\n";
+  json << "  \"allocations_per_decision\": " << double(allocs)/double(samples.size()) << ",\n";
+  json << "  \"allocated_bytes_per_decision\": " << double(bytes)/double(samples.size()) << ",\n";
+  json << "  \"noop_ratio\": " << double(noOps)/double(samples.size()) << "\n";
+  json << "}\n";
+
+  if(output.empty()){
+    cout << json.str();
+  }
+  else{
+    ofstream file(output);
+    if(!file.is_open()){
+      cerr << "unable to write " << output << endl;
+      return 1;
+    }
+    file << json.str();
+  }
+  return 0;
+}
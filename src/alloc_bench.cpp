@@ -0,0 +1,154 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d_alloc_bench: heap allocations made by the simulator in each tick, optionally asserting there are none after a warm-up
+#include "simulator.h"
+#include "simple_player.h"
+#include "alloc_counter.h"  // every allocation of this executable is counted
+
+using namespace std;
+using namespace r2s;
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+static void usage(){
+  cout << "usage: robosoc2d_alloc_bench [--agents simple|given] [--players N] [--warmup N] [--ticks N] [--full] [--history]" << endl;
+  cout << "                             [--seed N] [--assert-zero] [--output FILE]" << endl;
+  cout << "  plays a match for warm-up ticks, then counts the heap allocations of each of the following ticks." << endl;
+  cout << "  --agents given: the agents are never asked, all players perform NoOp through stepN(), so only the simulator is measured." << endl;
+  cout << "  --assert-zero: exits with code 2 if any allocation has been made after the warm-up." << endl;
+  cout << "  The allocations of each phase are reported only if compiled with -DROBOSOC2D_PROFILE=ON." << endl;
+}
+
+int main(int argc, char** argv)
+{
+  string agents="simple";
+  int players=4;
+  int warmupTicks=200;
+  int ticks=1000;
+  bool simplified=true;
+  bool history=false;
+  bool assertZero=false;
+  unsigned int seed=1;
+  string output;
+
+  for(int i=1; i<argc; i++){
+    bool hasValue= (i+1<argc);
+    if((strcmp(argv[i], "--agents")==0) && hasValue)
+      agents=argv[++i];
+    else if((strcmp(argv[i], "--players")==0) && hasValue)
+      players=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--warmup")==0) && hasValue)
+      warmupTicks=max(0, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--ticks")==0) && hasValue)
+      ticks=max(1, stoi(argv[++i]));
+    else if(strcmp(argv[i], "--full")==0)
+      simplified=false;
+    else if(strcmp(argv[i], "--history")==0)
+      history=true;
+    else if((strcmp(argv[i], "--seed")==0) && hasValue)
+      seed=stoul(argv[++i]);
+    else if(strcmp(argv[i], "--assert-zero")==0)
+      assertZero=true;
+    else if((strcmp(argv[i], "--output")==0) && hasValue)
+      output=argv[++i];
+    else{
+      usage();
+      return 1;
+    }
+  }
+  if((agents!="simple") && (agents!="given")){
+    usage();
+    return 1;
+  }
+  bool given= (agents=="given");
+
+  R2EnvSettings sett(simplified);
+  sett.ticksPerTime=max(sett.ticksPerTime, (warmupTicks+ticks)/2+1);  // the match must not end before the measure
+  auto simulator= buildSimulator<SimplePlayer,SimplePlayer>(players, players, defaultTeam1Name, defaultTeam2Name, seed, sett);
+  simulator->setHistoryEnabled(history);
+  vector<R2Action> noOps(players*2, R2Action());
+
+  auto stepOnce=[&](){
+    if(given)
+      return simulator->stepN(1, noOps).ticks==1;
+    return simulator->stepIfPlaying();
+  };
+
+  for(int t=0; t<warmupTicks; t++)
+    stepOnce();
+  simulator->clearProfile();
+
+  uint64_t allocations=0, bytes=0, maxTickAllocations=0;
+  int allocatingTicks=0, firstAllocatingTick=-1;
+  int measuredTicks=0;
+  for(; measuredTicks<ticks; measuredTicks++){
+    uint64_t allocsBefore=R2Allocations::count, bytesBefore=R2Allocations::bytes;
+    if(!stepOnce())
+      break;
+    uint64_t allocs=R2Allocations::count-allocsBefore;
+    allocations+=allocs;
+    bytes+=R2Allocations::bytes-bytesBefore;
+    maxTickAllocations=max(maxTickAllocations, allocs);
+    if(allocs>0){
+      if(firstAllocatingTick<0)
+        firstAllocatingTick=warmupTicks+measuredTicks;
+      allocatingTicks++;
+    }
+  }
+  if(measuredTicks==0){
+    cerr << "the match ended during the warm-up" << endl;
+    return 1;
+  }
+
+  ostringstream json;
+  json.precision(6);
+  json << "{\n";
+  json << "  \"version\": \"" << R2SVersion << "\",\n";
+  json << "  \"profiling\": " << (R2Profile::enabled() ? "true" : "false") << ",\n";
+  json << "  \"agents\": \"" << agents << "\",\n";
+  json << "  \"players\": " << players << ",\n";
+  json << "  \"simplified\": " << (simplified ? "true" : "false") << ",\n";
+  json << "  \"history\": " << (history ? "true" : "false") << ",\n";
+  json << "  \"warmup_ticks\": " << warmupTicks << ",\n";
+  json << "  \"ticks\": " << measuredTicks << ",\n";
+  json << "  \"allocations_per_tick\": " << double(allocations)/double(measuredTicks) << ",\n";
+  json << "  \"allocated_bytes_per_tick\": " << double(bytes)/double(measuredTicks) << ",\n";
+  json << "  \"max_tick_allocations\": " << maxTickAllocations << ",\n";
+  json << "  \"allocating_ticks\": " << allocatingTicks << ",\n";
+  json << "  \"first_allocating_tick\": " << firstAllocatingTick;
+  if(R2Profile::enabled()){
+    const R2Profile& profile=simulator->getProfile();
+    json << ",\n  \"phases\": {\n";
+    for(int i=0; i<R2PhaseCount; i++){
+      const R2PhaseStats& stats=profile.phases[i];
+      json << "    \"" << getPhaseName(R2Phase(i)) << "\": {\"allocations_per_tick\": " << double(stats.allocations)/double(measuredTicks)
+        << ", \"max_tick_allocations\": " << stats.maxTickAllocations << ", \"allocating_ticks\": " << stats.allocatingTicks << "}"
+        << ((i+1<R2PhaseCount) ? "," : "") << "\n";
+    }
+    json << "  }";
+  }
+  json << "\n}\n";
+
+  if(output.empty()){
+    cout << json.str();
+  }
+  else{
+    ofstream file(output);
+    if(!file.is_open()){
+      cerr << "unable to write " << output << endl;
+      return 1;
+    }
+    file << json.str();
+  }
+
+  if(assertZero && (allocations>0)){
+    cerr << allocations << " allocations in " << allocatingTicks << " ticks after the warm-up, the first one at tick " << firstAllocatingTick << endl;
+    return 2;
+  }
+  return 0;
+}
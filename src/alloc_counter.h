@@ -0,0 +1,40 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d : global operator new replacement counting the heap allocations in R2Allocations (see profiler.h).
+// Include it in exactly one source file of an executable (the benchmarks do it), never in the library or in the python extension.
+#ifndef R2S_ALLOC_COUNTER_H
+#define R2S_ALLOC_COUNTER_H
+
+#include <cstdlib>
+#include <new>
+#include "profiler.h"
+
+[[maybe_unused]] static const bool r2sAllocationsCounted= (r2s::R2Allocations::counted=true);
+
+void* operator new(std::size_t size){
+    r2s::R2Allocations::count.fetch_add(1, std::memory_order_relaxed);
+    r2s::R2Allocations::bytes.fetch_add(size, std::memory_order_relaxed);
+    void* p=std::malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    r2s::R2Allocations::count.fetch_add(1, std::memory_order_relaxed);
+    r2s::R2Allocations::bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+// once these are inlined, gcc sees free() releasing memory that came from operator new and warns about it, wrongly here
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__>=11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__>=11)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // R2S_ALLOC_COUNTER_H
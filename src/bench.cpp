@@ -0,0 +1,216 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d_bench: end-to-end simulation throughput on a fixed matrix of configurations, with JSON output
+#include "simulator.h"
+#include "simple_player.h"
+
+using namespace std;
+using namespace r2s;
+
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+struct BenchConfig {
+  int players;      // per team
+  bool simplified;
+  bool regularPitch;  // 105x68 instead of the default small pitch
+  bool history;
+};
+
+struct BenchRun {
+  double seconds;
+  long long ticks;
+  int goals;  // sum of all scores
+  uint64_t digest;  // combination of the state digests of the matches, the same for every repetition if the simulation is deterministic
+};
+
+static R2EnvSettings benchSettings(const BenchConfig& c, int ticksPerTime){
+  if(c.regularPitch)
+    return R2EnvSettings(c.simplified, RegularPitchLength, RegularPitchWidth, RegularGoalWidth, RegularCornerDistance, ticksPerTime);
+  R2EnvSettings sett(c.simplified);
+  sett.ticksPerTime=ticksPerTime;
+  return sett;
+}
+
+// plays the matches with seeds firstSeed, firstSeed+1, ... building a new simulator for each of them
+static BenchRun runMatches(const BenchConfig& c, int matches, int ticksPerTime, unsigned int firstSeed, int agentThreads, int observationLatency, bool eventDriven, bool quiescence,
+  double staticTolerance){
+  R2EnvSettings sett=benchSettings(c, ticksPerTime);
+  BenchRun run{0.0, 0, 0, 0};
+
+  auto start=chrono::steady_clock::now();
+  for(int m=0; m<matches; m++){
+    auto simulator= buildSimulator<SimplePlayer,SimplePlayer>(c.players, c.players, defaultTeam1Name, defaultTeam2Name, firstSeed+m, sett);
+    if(!c.history)
+      simulator->setHistoryEnabled(false);
+    simulator->setAgentThreads(agentThreads);
+    simulator->setObservationLatency(observationLatency);
+    simulator->setEventDrivenCollisions(eventDriven);
+    simulator->setQuiescenceEarlyOut(quiescence);
+    simulator->setStaticRelaxation(staticTolerance);
+    simulator->playMatch();
+    R2Environment env=simulator->getGameState().env;
+    run.ticks+= sett.ticksPerTime*2;
+    run.goals+= env.score1+env.score2;
+    run.digest= run.digest*31 + simulator->getStateDigest();
+  }
+  run.seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+  return run;
+}
+
+static double median(vector<double> v){
+  sort(v.begin(), v.end());
+  size_t n=v.size();
+  if(n==0)
+    return 0.0;
+  return (n%2) ? v[n/2] : (v[n/2-1]+v[n/2])/2.0;
+}
+
+static void usage(){
+  cout << "usage: robosoc2d_bench [--repeats N] [--matches N] [--ticks-per-time N] [--seed N] [--players N] [--agent-threads N]" << endl;
+  cout << "                        [--observation-latency N] [--event-driven-collisions] [--no-quiescence]" << endl;
+  cout << "                        [--static-tolerance X] [--output FILE]" << endl;
+  cout << "  runs every combination of team size (1,4,5,11 or the chosen one), simplified/full rules, default/105x68 pitch, history on/off" << endl;
+  cout << "  --agent-threads: runs the agents on N threads (see R2Simulator::setAgentThreads()), the digests must not change" << endl;
+  cout << "  --observation-latency: the agents act on the game state of N ticks before, running on a background thread (see R2Simulator::setObservationLatency())" << endl;
+  cout << "  --event-driven-collisions: uses the event-driven collision solver (see R2Simulator::setEventDrivenCollisions())" << endl;
+  cout << "  --no-quiescence: searches the collisions also in the ticks where no objects can meet (see R2Simulator::setQuiescenceEarlyOut()), the digests must not change" << endl;
+  cout << "  --static-tolerance: stops separating the overlapping players when no overlap is deeper than X (StaticTolerance if missing, see R2Simulator::setStaticRelaxation())" << endl;
+}
+
+int main(int argc, char** argv)
+{
+  int repeats=3;
+  int matches=2;
+  int ticksPerTime=R2EnvSettings().ticksPerTime;
+  unsigned int seed=1;
+  int onlyPlayers=0;
+  int agentThreads=1;
+  int observationLatency=0;
+  bool eventDriven=false;
+  bool quiescence=true;
+  double staticTolerance=StaticTolerance;
+  string output;
+
+  for(int i=1; i<argc; i++){
+    bool hasValue= (i+1<argc);
+    if((strcmp(argv[i], "--repeats")==0) && hasValue)
+      repeats=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--matches")==0) && hasValue)
+      matches=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--ticks-per-time")==0) && hasValue)
+      ticksPerTime=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--seed")==0) && hasValue)
+      seed=stoul(argv[++i]);
+    else if((strcmp(argv[i], "--players")==0) && hasValue)
+      onlyPlayers=stoi(argv[++i]);
+    else if((strcmp(argv[i], "--agent-threads")==0) && hasValue)
+      agentThreads=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--observation-latency")==0) && hasValue)
+      observationLatency=max(0, stoi(argv[++i]));
+    else if(strcmp(argv[i], "--event-driven-collisions")==0)
+      eventDriven=true;
+    else if(strcmp(argv[i], "--no-quiescence")==0)
+      quiescence=false;
+    else if((strcmp(argv[i], "--static-tolerance")==0) && hasValue)
+      staticTolerance=max(0.0, stod(argv[++i]));
+    else if((strcmp(argv[i], "--output")==0) && hasValue)
+      output=argv[++i];
+    else{
+      usage();
+      return 1;
+    }
+  }
+
+  vector<BenchConfig> configs;
+  for(int players : {1, 4, 5, 11}){
+    if(onlyPlayers && (players!=onlyPlayers))
+      continue;
+    for(bool simplified : {true, false})
+      for(bool regularPitch : {false, true})
+        for(bool history : {true, false})
+          configs.push_back(BenchConfig{players, simplified, regularPitch, history});
+  }
+  if(configs.empty()){
+    usage();
+    return 1;
+  }
+
+  ostringstream json;
+  json.precision(10);
+  json << "{\n";
+  json << "  \"version\": \"" << R2SVersion << "\",\n";
+#if defined(__OPTIMIZE__) || defined(NDEBUG)
+  json << "  \"optimized\": true,\n";
+#else
+  json << "  \"optimized\": false,\n";
+#endif
+  json << "  \"profiling\": " << (R2Profile::enabled() ? "true" : "false") << ",\n";
+  json << "  \"repeats\": " << repeats << ",\n";
+  json << "  \"matches\": " << matches << ",\n";
+  json << "  \"ticks_per_time\": " << ticksPerTime << ",\n";
+  json << "  \"seed\": " << seed << ",\n";
+  json << "  \"agent_threads\": " << agentThreads << ",\n";
+  json << "  \"observation_latency\": " << observationLatency << ",\n";
+  json << "  \"event_driven_collisions\": " << (eventDriven ? "true" : "false") << ",\n";
+  json << "  \"quiescence_early_out\": " << (quiescence ? "true" : "false") << ",\n";
+  json << "  \"static_tolerance\": " << staticTolerance << ",\n";
+  json << "  \"results\": [\n";
+
+  for(size_t c=0; c<configs.size(); c++){
+    const BenchConfig& config=configs[c];
+    runMatches(config, 1, min(ticksPerTime, 100), seed, agentThreads, observationLatency, eventDriven, quiescence, staticTolerance);  // warm-up
+
+    vector<BenchRun> runs;
+    vector<double> ticksPerSecond, matchesPerSecond;
+    bool deterministic=true;
+    for(int r=0; r<repeats; r++){
+      BenchRun run=runMatches(config, matches, ticksPerTime, seed, agentThreads, observationLatency, eventDriven, quiescence, staticTolerance);
+      if((r>0) && (run.digest!=runs[0].digest))
+        deterministic=false;
+      runs.push_back(run);
+      ticksPerSecond.push_back(double(run.ticks)/run.seconds);
+      matchesPerSecond.push_back(double(matches)/run.seconds);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%dv%d_%s_%s_history_%s", config.players, config.players, config.simplified ? "simplified" : "full",
+      config.regularPitch ? "105x68" : "default", config.history ? "on" : "off");
+    cerr << name << ": " << median(ticksPerSecond) << " ticks/s" << endl;
+
+    json << "    {\"name\": \"" << name << "\", \"players\": " << config.players
+      << ", \"simplified\": " << (config.simplified ? "true" : "false")
+      << ", \"pitch\": \"" << (config.regularPitch ? "105x68" : "default") << "\""
+      << ", \"history\": " << (config.history ? "true" : "false")
+      << ", \"goals\": " << runs[0].goals
+      << ", \"digest\": \"" << hex << runs[0].digest << dec << "\""
+      << ", \"deterministic\": " << (deterministic ? "true" : "false")
+      << ",\n     \"median_ticks_per_second\": " << median(ticksPerSecond)
+      << ", \"best_ticks_per_second\": " << *max_element(ticksPerSecond.begin(), ticksPerSecond.end())
+      << ", \"median_matches_per_second\": " << median(matchesPerSecond)
+      << ",\n     \"runs\": [";
+    for(size_t r=0; r<runs.size(); r++)
+      json << (r ? ", " : "") << "{\"seconds\": " << runs[r].seconds << ", \"ticks\": " << runs[r].ticks << "}";
+    json << "]}" << ((c+1<configs.size()) ? "," : "") << "\n";
+  }
+  json << "  ]\n}\n";
+
+  if(output.empty()){
+    cout << json.str();
+  }
+  else{
+    ofstream file(output);
+    if(!file.is_open()){
+      cerr << "unable to write " << output << endl;
+      return 1;
+    }
+    file << json.str();
+  }
+  return 0;
+}
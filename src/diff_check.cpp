@@ -0,0 +1,318 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d_diff: runs the simulator in lockstep with the frozen reference engine in reference/ (see freeze_reference.sh),
+// over many random seeds and crafted states, reporting the first tick at which their states diverge
+#include "simulator.h"
+#include "simple_player.h"
+#if defined(__GNUC__)   // the frozen reference engine is compiled without these warnings, see CMakeLists.txt
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include "reference/ref_simulator.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+using namespace std;
+using namespace r2s;
+
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <iostream>
+
+// the reference engine is a copy of the simulator, so the structs have the same fields in both, but the simulator may be
+// compiled in single precision (see R2Scalar in vec2.h) while the reference engine is always in double precision
+template <typename To, typename From>
+static To convertSettings(const From& from){
+  To to;
+  to.simplified=from.simplified; to.ticksPerTime=from.ticksPerTime; to.pitchLength=from.pitchLength; to.pitchWidth=from.pitchWidth;
+  to.goalWidth=from.goalWidth; to.centerRadius=from.centerRadius; to.poleRadius=from.poleRadius; to.ballRadius=from.ballRadius;
+  to.playerRadius=from.playerRadius; to.catchRadius=from.catchRadius; to.catchHoldingTicks=from.catchHoldingTicks; to.kickRadius=from.kickRadius;
+  to.kickableDistance=from.kickableDistance; to.catchableDistance=from.catchableDistance; to.kickableAngle=from.kickableAngle;
+  to.kickableDirectionAngle=from.kickableDirectionAngle; to.catchableAngle=from.catchableAngle; to.netLength=from.netLength;
+  to.catchableAreaLength=from.catchableAreaLength; to.catchableAreaWidth=from.catchableAreaWidth; to.cornerMinDistance=from.cornerMinDistance;
+  to.throwinMinDistance=from.throwinMinDistance; to.outPitchLimit=from.outPitchLimit; to.maxDashPower=from.maxDashPower;
+  to.maxKickPower=from.maxKickPower; to.playerVelocityDecay=from.playerVelocityDecay; to.ballVelocityDecay=from.ballVelocityDecay;
+  to.maxPlayerSpeed=from.maxPlayerSpeed; to.maxBallSpeed=from.maxBallSpeed; to.catchProbability=from.catchProbability;
+  to.playerRandomNoise=from.playerRandomNoise; to.playerDirectionNoise=from.playerDirectionNoise;
+  to.playerVelocityDirectionMix=from.playerVelocityDirectionMix; to.ballInsidePlayerVelocityDisplace=from.ballInsidePlayerVelocityDisplace;
+  to.afterCatchDistance=from.afterCatchDistance;
+  return to;
+}
+
+template <typename To, typename From>
+static To convertObject(const From& o){
+  return To(o.pos.x, o.pos.y, o.velocity.x, o.velocity.y);
+}
+
+template <typename To, typename From>
+static To convertPlayer(const From& p){
+  To player(p.pos.x, p.pos.y, p.velocity.x, p.velocity.y, p.direction);
+  player.acted=p.acted;
+  return player;
+}
+
+static R2Environment fromReference(const r2sref::R2Environment& ref){
+  R2Environment env(0, 0);
+  env.tick=ref.tick; env.score1=ref.score1; env.score2=ref.score2; env.state=R2State(int(ref.state));
+  env.ball=convertObject<R2ObjectInfo>(ref.ball);
+  for(int w=0; w<=1; w++)
+    for(auto& p : ref.teams[w])
+      env.teams[w].push_back(convertPlayer<R2PlayerInfo>(p));
+  env.lastTouchedTeam2=ref.lastTouchedTeam2; env.startingTeamMaxRange=ref.startingTeamMaxRange;
+  env.ballCatched=ref.ballCatched; env.ballCatchedTeam2=ref.ballCatchedTeam2; env.halftimePassed=ref.halftimePassed;
+  return env;
+}
+
+// lets the reference engine be driven by the same agents of the simulator
+template <typename player>
+class ReferencePlayer : public r2sref::R2Player {
+  player agent;
+public:
+  ReferencePlayer(int shirtNumber, int team) : agent(shirtNumber, team) {}
+  virtual r2sref::R2Action step(const r2sref::R2GameState gameState) override {
+    R2EnvSettings sett=convertSettings<R2EnvSettings>(gameState.sett);
+    R2Pitch pitch(sett.pitchWidth, sett.pitchLength, sett.goalWidth, sett.netLength, sett.poleRadius, sett.outPitchLimit);
+    R2Action action=agent.step(R2GameState(sett, fromReference(gameState.env), pitch));
+    return r2sref::R2Action(r2sref::R2ActionType(int(action.action)), action.data[0], action.data[1], action.data[2]);
+  }
+};
+
+struct Divergence {
+  int tick;
+  string what;
+};
+
+// true if the values differ: bit by bit if tolerance is 0
+static bool differ(double a, double b, double tolerance){
+  if(tolerance<=0.0)
+    return memcmp(&a, &b, sizeof(double))!=0;
+  if(std::isnan(a) || std::isnan(b))
+    return std::isnan(a)!=std::isnan(b);
+  return fabs(a-b)>tolerance;
+}
+
+static string describe(const char* field, double a, double b){
+  char s[160];
+  snprintf(s, sizeof(s), "%s: %.17g (reference %.17g)", field, a, b);
+  return s;
+}
+
+// first difference between the states of the two engines, empty string if none
+static string compareEnvironments(const R2Environment& env, const r2sref::R2Environment& ref, double tolerance){
+  if(env.tick!=ref.tick) return describe("tick", env.tick, ref.tick);
+  if(env.score1!=ref.score1) return describe("score1", env.score1, ref.score1);
+  if(env.score2!=ref.score2) return describe("score2", env.score2, ref.score2);
+  if(int(env.state)!=int(ref.state)) return describe("state", int(env.state), int(ref.state));
+  if(env.lastTouchedTeam2!=ref.lastTouchedTeam2) return describe("lastTouchedTeam2", env.lastTouchedTeam2, ref.lastTouchedTeam2);
+  if(env.ballCatched!=ref.ballCatched) return describe("ballCatched", env.ballCatched, ref.ballCatched);
+  if(env.ballCatchedTeam2!=ref.ballCatchedTeam2) return describe("ballCatchedTeam2", env.ballCatchedTeam2, ref.ballCatchedTeam2);
+  if(env.halftimePassed!=ref.halftimePassed) return describe("halftimePassed", env.halftimePassed, ref.halftimePassed);
+  if(differ(env.startingTeamMaxRange, ref.startingTeamMaxRange, tolerance)) return describe("startingTeamMaxRange", env.startingTeamMaxRange, ref.startingTeamMaxRange);
+  if(differ(env.ball.pos.x, ref.ball.pos.x, tolerance)) return describe("ball.pos.x", env.ball.pos.x, ref.ball.pos.x);
+  if(differ(env.ball.pos.y, ref.ball.pos.y, tolerance)) return describe("ball.pos.y", env.ball.pos.y, ref.ball.pos.y);
+  if(differ(env.ball.velocity.x, ref.ball.velocity.x, tolerance)) return describe("ball.velocity.x", env.ball.velocity.x, ref.ball.velocity.x);
+  if(differ(env.ball.velocity.y, ref.ball.velocity.y, tolerance)) return describe("ball.velocity.y", env.ball.velocity.y, ref.ball.velocity.y);
+  for(int w=0; w<=1; w++){
+    if(env.teams[w].size()!=ref.teams[w].size())
+      return describe(w ? "team2 size" : "team1 size", env.teams[w].size(), ref.teams[w].size());
+    for(size_t n=0; n<env.teams[w].size(); n++){
+      const R2PlayerInfo& p=env.teams[w][n];
+      const r2sref::R2PlayerInfo& r=ref.teams[w][n];
+      string player= string(w ? "team2[" : "team1[") + to_string(n) + "].";
+      if(differ(p.pos.x, r.pos.x, tolerance)) return describe((player+"pos.x").c_str(), p.pos.x, r.pos.x);
+      if(differ(p.pos.y, r.pos.y, tolerance)) return describe((player+"pos.y").c_str(), p.pos.y, r.pos.y);
+      if(differ(p.velocity.x, r.velocity.x, tolerance)) return describe((player+"velocity.x").c_str(), p.velocity.x, r.velocity.x);
+      if(differ(p.velocity.y, r.velocity.y, tolerance)) return describe((player+"velocity.y").c_str(), p.velocity.y, r.velocity.y);
+      if(differ(p.direction, r.direction, tolerance)) return describe((player+"direction").c_str(), p.direction, r.direction);
+      if(p.acted!=r.acted) return describe((player+"acted").c_str(), p.acted, r.acted);
+    }
+  }
+  return string();
+}
+
+// steps both engines until the match ends or maxTicks have been played, returning the first divergence (tick -1 if none)
+static Divergence runLockstep(R2Simulator& sim, r2sref::R2Simulator& ref, int maxTicks, double tolerance){
+  string what=compareEnvironments(sim.getGameState().env, ref.getGameState().env, tolerance);
+  if(!what.empty())
+    return Divergence{sim.getGameState().env.tick, what};
+  for(int t=0; t<maxTicks; t++){
+    bool playing=sim.stepIfPlaying();
+    bool refPlaying=ref.stepIfPlaying();
+    what=compareEnvironments(sim.getGameState().env, ref.getGameState().env, tolerance);
+    if(what.empty() && (playing!=refPlaying))
+      what="end of match";
+    if(!what.empty())
+      return Divergence{sim.getGameState().env.tick, what};
+    if(!playing)
+      break;
+  }
+  return Divergence{-1, string()};
+}
+
+template <typename Settings>
+static Settings caseSettings(bool simplified, int ticksPerTime){
+  Settings sett(simplified);
+  sett.ticksPerTime=ticksPerTime;
+  return sett;
+}
+
+// a random state during play, with part of the players crowded around the ball to have many collisions
+static void craftState(R2Simulator& sim, r2sref::R2Simulator& ref, const R2EnvSettings& sett, int players1, int players2, std::mt19937& gen){
+  uniform_real_distribution<double> x(-sett.pitchLength/2, sett.pitchLength/2), y(-sett.pitchWidth/2, sett.pitchWidth/2);
+  uniform_real_distribution<double> unit(-1.0, 1.0), angle(-M_PI, M_PI);
+  R2ObjectInfo ball(x(gen)*0.9, y(gen)*0.9, unit(gen)*sett.maxBallSpeed, unit(gen)*sett.maxBallSpeed);
+  vector<R2PlayerInfo> teams[2];
+  for(int w=0; w<=1; w++)
+    for(int n=0; n< (w ? players2 : players1); n++){
+      Vec2 pos= (gen()%2) ? Vec2(ball.pos.x + unit(gen)*sett.playerRadius*4, ball.pos.y + unit(gen)*sett.playerRadius*4) : Vec2(x(gen), y(gen));
+      teams[w].push_back(R2PlayerInfo(pos.x, pos.y, unit(gen)*sett.maxPlayerSpeed, unit(gen)*sett.maxPlayerSpeed, angle(gen)));
+    }
+  int tick=int(gen()%(sett.ticksPerTime*2));
+  bool lastTouchedTeam2=gen()%2;
+  sim.setEnvironment(tick, 0, 0, R2State::Play, ball, teams[0], teams[1], lastTouchedTeam2, 0, false);
+
+  vector<r2sref::R2PlayerInfo> refTeams[2];
+  for(int w=0; w<=1; w++)
+    for(auto& p : teams[w])
+      refTeams[w].push_back(convertPlayer<r2sref::R2PlayerInfo>(p));
+  ref.setEnvironment(tick, 0, 0, r2sref::R2State::Play, convertObject<r2sref::R2ObjectInfo>(ball), refTeams[0], refTeams[1], lastTouchedTeam2, 0, false);
+}
+
+// largest absolute errors of the functions of fast_trig.h against the standard ones, all zeros unless compiled with _R2S_FAST_TRIG
+struct TrigErrors {
+  double sinCos, atan2, remainder;
+};
+
+static TrigErrors measureTrig(int samples){
+  std::mt19937 gen(2021);
+  uniform_real_distribution<double> angle(-4*M_PI, 4*M_PI), wide(-FastTrigMaxAngle, FastTrigMaxAngle), unit(-1.0, 1.0);
+  uniform_real_distribution<double> exponent(-30.0, 30.0);
+  TrigErrors e{0.0, 0.0, 0.0};
+  for(int i=0; i<samples; i++){
+    double a= (i%8) ? angle(gen) : wide(gen);
+    double s, c;
+    fsincos(a, s, c);
+    e.sinCos=max(e.sinCos, max(fabs(s-sin(a)), fabs(c-cos(a))));
+    e.sinCos=max(e.sinCos, max(fabs(fsin(a)-sin(a)), fabs(fcos(a)-cos(a))));
+
+    double scale=pow(2.0, exponent(gen));
+    double y=unit(gen)*scale, x=unit(gen)*scale*((i%4) ? 1.0 : 1e-6);
+    e.atan2=max(e.atan2, fabs(fatan2(y, x)-atan2(y, x)));
+
+    double period= (i%2) ? M_PI : 2*M_PI;
+    double r=fremainder(a, period)-remainder(a, period);
+    if(fabs(r)>period/2)    // halfway between two multiples of period, the sign of the result may differ
+      r=fabs(r)-period;
+    e.remainder=max(e.remainder, fabs(r)/max(1.0, fabs(a)));
+  }
+  return e;
+}
+
+static void usage(){
+  cout << "usage: robosoc2d_diff [--seeds N] [--first-seed N] [--ticks-per-time N] [--crafted N] [--crafted-ticks N] [--players N] [--tolerance X]" << endl;
+  cout << "                      [--collision-threads N] [--trig-samples N]" << endl;
+  cout << "  plays --seeds matches from their beginning, then --crafted random states during play for --crafted-ticks ticks each," << endl;
+  cout << "  with both the simulator and the reference engine. The states are compared bit by bit at every tick, or with an absolute" << endl;
+  cout << "  tolerance on the floating point values if --tolerance is > 0 (needed when compiled with -DROBOSOC2D_FLOAT=ON, since the" << endl;
+  cout << "  reference engine is in double precision). Team sizes cycle among 1,4,5,11 unless --players is given." << endl;
+  cout << "  --collision-threads searches the collisions of the simulator on N threads whatever the team size (see R2Simulator::setCollisionThreads())." << endl;
+  cout << "  Before that it measures the errors of the functions of fast_trig.h against the standard ones on --trig-samples arguments:" << endl;
+  cout << "  they are zero unless compiled with -DROBOSOC2D_FAST_TRIG=ON, then the states must be compared with --tolerance." << endl;
+  cout << "  Exits with code 1 if any divergence has been found, or any of those errors exceeds its bound." << endl;
+}
+
+int main(int argc, char** argv)
+{
+  int seeds=1000;
+  unsigned int firstSeed=1;
+  int ticksPerTime=300;
+  int crafted=1000;
+  int craftedTicks=50;
+  int onlyPlayers=0;
+  double tolerance=0.0;
+  int collisionThreads=1;
+  int trigSamples=1000000;
+
+  for(int i=1; i<argc; i++){
+    bool hasValue= (i+1<argc);
+    if((strcmp(argv[i], "--seeds")==0) && hasValue)
+      seeds=max(0, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--first-seed")==0) && hasValue)
+      firstSeed=stoul(argv[++i]);
+    else if((strcmp(argv[i], "--ticks-per-time")==0) && hasValue)
+      ticksPerTime=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--crafted")==0) && hasValue)
+      crafted=max(0, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--crafted-ticks")==0) && hasValue)
+      craftedTicks=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--players")==0) && hasValue)
+      onlyPlayers=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--tolerance")==0) && hasValue)
+      tolerance=max(0.0, stod(argv[++i]));
+    else if((strcmp(argv[i], "--collision-threads")==0) && hasValue)
+      collisionThreads=max(1, stoi(argv[++i]));
+    else if((strcmp(argv[i], "--trig-samples")==0) && hasValue)
+      trigSamples=max(0, stoi(argv[++i]));
+    else{
+      usage();
+      return 1;
+    }
+  }
+
+  TrigErrors trig=measureTrig(trigSamples);
+  bool trigExceeded= (trig.sinCos>FastTrigSinCosMaxError) || (trig.atan2>FastTrigAtan2MaxError) || (trig.remainder>FastTrigRemainderMaxError);
+  cout << "trigonometry max errors on " << trigSamples << " arguments: sin/cos " << trig.sinCos << " (bound " << FastTrigSinCosMaxError
+    << "), atan2 " << trig.atan2 << " (bound " << FastTrigAtan2MaxError << "), remainder " << trig.remainder << " times max(1,|x|) (bound "
+    << FastTrigRemainderMaxError << ")" << (trigExceeded ? ": EXCEEDED" : "") << endl;
+
+  const int teamSizes[]={1, 4, 5, 11};
+  int divergences=0;
+  const int MaxReported=10;
+
+  for(int c=0; c<seeds+crafted; c++){
+    bool isCrafted= (c>=seeds);
+    unsigned int seed=firstSeed+c;
+    int players= onlyPlayers ? onlyPlayers : teamSizes[c%4];
+    bool simplified= ((c/4)%2)==0;
+    R2EnvSettings sett=caseSettings<R2EnvSettings>(simplified, ticksPerTime);
+
+    auto sim=buildSimulator<SimplePlayer,SimplePlayer>(players, players, defaultTeam1Name, defaultTeam2Name, seed, sett);
+    auto ref=r2sref::buildSimulator<ReferencePlayer<SimplePlayer>,ReferencePlayer<SimplePlayer>>(players, players,
+      r2sref::defaultTeam1Name, r2sref::defaultTeam2Name, seed, caseSettings<r2sref::R2EnvSettings>(simplified, ticksPerTime));
+    sim->setHistoryEnabled(false);
+    ref->setHistoryEnabled(false);
+    sim->setCollisionThreads(collisionThreads, 0);
+    sim->setStaticRelaxation(0.0);   // the reference engine separates the players until no overlap is left
+
+    Divergence d;
+    if(isCrafted){
+      std::mt19937 gen(seed);
+      craftState(*sim, *ref, sett, players, players, gen);
+      d=runLockstep(*sim, *ref, craftedTicks, tolerance);
+    }
+    else{
+      d=runLockstep(*sim, *ref, ticksPerTime*2+1, tolerance);
+    }
+
+    if(d.tick>=0){
+      divergences++;
+      if(divergences<=MaxReported)
+        cout << (isCrafted ? "crafted state" : "match") << " with seed " << seed << " (" << players << "v" << players << ", "
+          << (simplified ? "simplified" : "full") << "): first divergence at tick " << d.tick << ", " << d.what << endl;
+    }
+  }
+
+  cout << seeds << " matches and " << crafted << " crafted states compared ";
+  if(tolerance>0.0)
+    cout << "with tolerance " << tolerance;
+  else
+    cout << "bit by bit";
+  cout << ": " << divergences << " diverged" << endl;
+  return (divergences || trigExceeded) ? 1 : 0;
+}
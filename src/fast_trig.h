@@ -0,0 +1,184 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d : trigonometric functions of the simulator, the standard ones or, if compiled with _R2S_FAST_TRIG, inline polynomial approximations
+#ifndef R2S_FAST_TRIG_H
+#define R2S_FAST_TRIG_H
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// By default fsin(), fcos(), fatan2() and fremainder() are just std::sin(), std::cos(), std::atan2() and std::remainder(),
+// so the matches are the same on every platform whose math library rounds them in the same way.
+// With _R2S_FAST_TRIG (on CMake use the option -DROBOSOC2D_FAST_TRIG=ON) they are computed inline with the minimax polynomials
+// of fdlibm, fsincos() reducing the argument only once for both. Their errors are below the FastTrig...MaxError
+// bounds below (robosoc2d_diff checks them), that are a few units in the last place: the physics is the same, but since
+// the last bits differ the matches are not the same of the default build.
+
+namespace r2s {
+
+constexpr double FastTrigSinCosMaxError=2.3e-16;    // absolute, for |angle| <= FastTrigMaxAngle (beyond it the standard functions are used)
+constexpr double FastTrigAtan2MaxError=9e-16;       // absolute, in radians
+constexpr double FastTrigRemainderMaxError=2.3e-16; // relative to max(1,|x|), for the periods used by the simulator (pi and 2 pi); halfway
+                                                    // between two multiples of the period the result may be -period/2 instead of period/2
+constexpr double FastTrigMaxAngle=1e5;
+
+// the standard functions, whatever the build: the frozen reference engine of robosoc2d_diff uses them (see freeze_reference.sh)
+namespace stdtrig {
+inline void sincos(double x, double& s, double& c){ s=std::sin(x); c=std::cos(x); }
+inline double sin(double x){ return std::sin(x); }
+inline double cos(double x){ return std::cos(x); }
+inline double atan2(double y, double x){ return std::atan2(y, x); }
+inline double remainder(double x, double period){ return std::remainder(x, period); }
+inline void sincos(float x, float& s, float& c){ s=std::sin(x); c=std::cos(x); }
+inline float sin(float x){ return std::sin(x); }
+inline float cos(float x){ return std::cos(x); }
+inline float atan2(float y, float x){ return std::atan2(y, x); }
+inline float remainder(float x, double period){ return std::remainder(x, float(period)); }
+} // end namespace stdtrig
+
+#ifdef _R2S_FAST_TRIG
+
+namespace fasttrig {
+
+// round to nearest, ties to even, for |x| < 2^51, without a library call
+inline double roundEven(double x){
+    const double magic=6755399441055744.0;  // 1.5*2^52
+    return (x+magic)-magic;
+}
+
+// sine and cosine for |x| <= pi/4
+inline double kernelSin(double x){
+    const double S1=-1.66666666666666324348e-01, S2=8.33333333332248946124e-03, S3=-1.98412698298579493134e-04,
+        S4=2.75573137070700676789e-06, S5=-2.50507602534068634195e-08, S6=1.58969099521155010221e-10;
+    double z=x*x;
+    return x + x*z*(S1 + z*(S2 + z*(S3 + z*(S4 + z*(S5 + z*S6)))));
+}
+
+inline double kernelCos(double x){
+    const double C1=4.16666666666666019037e-02, C2=-1.38888888888741095749e-03, C3=2.48015872894767294178e-05,
+        C4=-2.75573143513906633035e-07, C5=2.08757232129817482790e-09, C6=-1.13596475577881948265e-11;
+    double z=x*x;
+    double hz=0.5*z;
+    double w=1.0-hz;
+    return w + (((1.0-w)-hz) + z*z*(C1 + z*(C2 + z*(C3 + z*(C4 + z*(C5 + z*C6))))));
+}
+
+// x = n*pi/2 + r, |r| <= pi/4 (Cody-Waite, pi/2 split in 33 bits and the rest)
+inline int reduce(double x, double& r){
+    const double invPio2=6.36619772367581382433e-01, pio2Hi=1.57079632673412561417e+00, pio2Lo=6.07710050650619224932e-11;
+    double n=roundEven(x*invPio2);
+    r=(x - n*pio2Hi) - n*pio2Lo;
+    return int(n) & 3;
+}
+
+// atan for |x| <= 7/16
+inline double kernelAtan(double x){
+    const double aT0=3.33333333333329318027e-01, aT1=-1.99999999998764832476e-01, aT2=1.42857142725034663711e-01,
+        aT3=-1.11111104054623557880e-01, aT4=9.09088713343650656196e-02, aT5=-7.69187620504482999495e-02,
+        aT6=6.66107313738753120669e-02, aT7=-5.83357013379057348645e-02, aT8=4.97687799461593236017e-02,
+        aT9=-3.65315727442169155270e-02, aT10=1.62858201153657823623e-02;
+    double z=x*x;
+    double w=z*z;
+    double s1=z*(aT0 + w*(aT2 + w*(aT4 + w*(aT6 + w*(aT8 + w*aT10)))));
+    double s2=w*(aT1 + w*(aT3 + w*(aT5 + w*(aT7 + w*aT9))));
+    return x - x*(s1+s2);
+}
+
+} // end namespace fasttrig
+
+inline void fsincos(double x, double& s, double& c){
+    if(!(std::fabs(x)<=FastTrigMaxAngle)){  // also NaN and infinities
+        s=std::sin(x);
+        c=std::cos(x);
+        return;
+    }
+    double r;
+    int quadrant=fasttrig::reduce(x, r);
+    double sr=fasttrig::kernelSin(r);
+    double cr=fasttrig::kernelCos(r);
+    switch(quadrant){
+        case 0: s=sr;  c=cr;  break;
+        case 1: s=cr;  c=-sr; break;
+        case 2: s=-sr; c=-cr; break;
+        default: s=-cr; c=sr; break;
+    }
+}
+
+inline double fsin(double x){
+    if(!(std::fabs(x)<=FastTrigMaxAngle))
+        return std::sin(x);
+    double r;
+    switch(fasttrig::reduce(x, r)){
+        case 0: return fasttrig::kernelSin(r);
+        case 1: return fasttrig::kernelCos(r);
+        case 2: return -fasttrig::kernelSin(r);
+        default: return -fasttrig::kernelCos(r);
+    }
+}
+
+inline double fcos(double x){
+    if(!(std::fabs(x)<=FastTrigMaxAngle))
+        return std::cos(x);
+    double r;
+    switch(fasttrig::reduce(x, r)){
+        case 0: return fasttrig::kernelCos(r);
+        case 1: return -fasttrig::kernelSin(r);
+        case 2: return -fasttrig::kernelCos(r);
+        default: return fasttrig::kernelSin(r);
+    }
+}
+
+inline double fatan2(double y, double x){
+    double ax=std::fabs(x), ay=std::fabs(y);
+    if(!((ax>0.0 || ay>0.0) && (ax<HUGE_VAL) && (ay<HUGE_VAL)))     // zeros, infinities and NaN, with their signs
+        return std::atan2(y, x);
+    const double tanPi8=0.41421356237309503, pio4=7.85398163397448278999e-01, pio2=1.57079632679489655800e+00;
+    bool swapped= ay>ax;
+    double t= swapped ? ax/ay : ay/ax;  // in [0,1]
+    double a;
+    if(t>tanPi8)
+        a=pio4 + fasttrig::kernelAtan((t-1.0)/(t+1.0));
+    else
+        a=fasttrig::kernelAtan(t);
+    if(swapped)
+        a=pio2-a;
+    if(x<0.0)
+        a=M_PI-a;
+    return std::signbit(y) ? -a : a;
+}
+
+// IEEE remainder of x/period (the result is in [-period/2, period/2])
+inline double fremainder(double x, double period){
+    if(!(std::fabs(x)<=FastTrigMaxAngle))
+        return std::remainder(x, period);
+    return x - period*fasttrig::roundEven(x/period);
+}
+
+// single precision (see R2Scalar in vec2.h): computed in double precision, then rounded
+inline void fsincos(float x, float& s, float& c){ double sd, cd; fsincos(double(x), sd, cd); s=float(sd); c=float(cd); }
+inline float fsin(float x){ return float(fsin(double(x))); }
+inline float fcos(float x){ return float(fcos(double(x))); }
+inline float fatan2(float y, float x){ return float(fatan2(double(y), double(x))); }
+inline float fremainder(float x, double period){ return float(fremainder(double(x), period)); }
+
+#else
+
+inline void fsincos(double x, double& s, double& c){ stdtrig::sincos(x, s, c); }
+inline double fsin(double x){ return stdtrig::sin(x); }
+inline double fcos(double x){ return stdtrig::cos(x); }
+inline double fatan2(double y, double x){ return stdtrig::atan2(y, x); }
+inline double fremainder(double x, double period){ return stdtrig::remainder(x, period); }
+inline void fsincos(float x, float& s, float& c){ stdtrig::sincos(x, s, c); }
+inline float fsin(float x){ return stdtrig::sin(x); }
+inline float fcos(float x){ return stdtrig::cos(x); }
+inline float fatan2(float y, float x){ return stdtrig::atan2(y, x); }
+inline float fremainder(float x, double period){ return stdtrig::remainder(x, period); }
+
+#endif
+
+} // end namespace
+
+#endif // R2S_FAST_TRIG_H
@@ -0,0 +1,315 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d : times of impact of a moving circle against many circles, computed a few at a time with SSE2 or AVX
+#ifndef R2S_IMPACT_KERNEL_H
+#define R2S_IMPACT_KERNEL_H
+
+#include "vec2.h"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP>=2))
+#define R2S_IMPACT_SIMD
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Each lane performs the same operations, in the same order, as findObjectsCollision() and intersectionSegmentCircle(), and IEEE
+// additions, multiplications, divisions and square roots are correctly rounded in scalar and vector registers alike: so the times
+// are bit-identical to the ones found one pair at a time. That would not hold if the compiler fused multiplications and additions,
+// so do not build with -mfma or -march=native (4 lanes need only -mavx2, see the ROBOSOC2D_AVX2 option of CMakeLists.txt).
+// With _R2S_FLOAT the values are single precision and the lanes twice as many: 4 with SSE2, 8 with AVX.
+
+namespace r2s {
+
+constexpr R2Scalar R2NoImpact=1.1;    // the time given to the targets that are not hit, later than any impact
+
+// the target circles, one array for each coordinate so that consecutive targets can be loaded in a vector register
+struct R2ImpactTargets {
+    std::vector<R2Scalar> x, y, vx, vy;
+
+    int size() const { return int(x.size()); }
+    void resize(int n){ x.resize(n); y.resize(n); vx.resize(n); vy.resize(n); }
+    void set(int i, Vec2 pos, Vec2 velocity){ x[i]=pos.x; y[i]=pos.y; vx[i]=velocity.x; vy[i]=velocity.y; }
+};
+
+// the output buffers of a search: times of impact indexed as the targets, and a bit for each tied target of the range searched
+struct R2ImpactScratch {
+    std::vector<R2Scalar> times;
+    std::vector<uint64_t> ties;
+
+    void reserve(int targets){
+        if(int(times.size()) < targets){
+            times.resize(targets);
+            ties.resize((targets+63)/64);
+        }
+    }
+};
+
+inline int lowestBit(uint64_t bits){
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return int(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// one target at a time, for the targets left out of the vector registers
+inline R2Scalar impactTime(const R2ImpactTargets& targets, int i, Vec2 pos, Vec2 velocity, R2Scalar rr, R2Scalar k, R2Scalar minT){
+    const R2Scalar two=2.0, four=4.0;
+    R2Scalar s2x= pos.x + (velocity.x - targets.vx[i])*k;
+    R2Scalar s2y= pos.y + (velocity.y - targets.vy[i])*k;
+    R2Scalar dx= pos.x - s2x;
+    R2Scalar dy= pos.y - s2y;
+    R2Scalar lx= pos.x - targets.x[i];
+    R2Scalar ly= pos.y - targets.y[i];
+    R2Scalar a= dx*dx - dy*dy;
+    R2Scalar b= two*dx*lx + two*dy*ly;
+    R2Scalar c= lx*lx + ly*ly - rr;
+    R2Scalar delta= b*b - four*a*c;
+    if(!(delta > 0.0))  // if tangent, no collision really happened
+        return R2NoImpact;
+    R2Scalar deltaRoot= std::sqrt(delta);
+    R2Scalar t1= (b-deltaRoot)/(two*a);
+    R2Scalar t2= (b+deltaRoot)/(two*a);
+    R2Scalar t= (t1>=0.0) ? t1 : t2;
+    return ((t>=minT) && (t<=1.0)) ? t : R2NoImpact;
+}
+
+#ifdef R2S_IMPACT_SIMD
+
+struct R2Sse2Lanes {
+    using V=__m128d;
+    static constexpr int Width=2;
+    static V set1(double x){ return _mm_set1_pd(x); }
+    static V load(const double* p){ return _mm_loadu_pd(p); }
+    static void store(double* p, V v){ _mm_storeu_pd(p, v); }
+    static V add(V a, V b){ return _mm_add_pd(a, b); }
+    static V sub(V a, V b){ return _mm_sub_pd(a, b); }
+    static V mul(V a, V b){ return _mm_mul_pd(a, b); }
+    static V div(V a, V b){ return _mm_div_pd(a, b); }
+    static V sqrt(V a){ return _mm_sqrt_pd(a); }
+    static V min(V a, V b){ return _mm_min_pd(a, b); }
+    static V greater(V a, V b){ return _mm_cmpgt_pd(a, b); }
+    static V greaterEqual(V a, V b){ return _mm_cmpge_pd(a, b); }
+    static V lessEqual(V a, V b){ return _mm_cmple_pd(a, b); }
+    static V equal(V a, V b){ return _mm_cmpeq_pd(a, b); }
+    static V both(V a, V b){ return _mm_and_pd(a, b); }
+    static V select(V mask, V a, V b){ return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+    static int bits(V mask){ return _mm_movemask_pd(mask); }
+    static double lowest(V v){ return std::min(_mm_cvtsd_f64(v), _mm_cvtsd_f64(_mm_unpackhi_pd(v, v))); }
+};
+
+#ifdef __AVX__
+struct R2AvxLanes {
+    using V=__m256d;
+    static constexpr int Width=4;
+    static V set1(double x){ return _mm256_set1_pd(x); }
+    static V load(const double* p){ return _mm256_loadu_pd(p); }
+    static void store(double* p, V v){ _mm256_storeu_pd(p, v); }
+    static V add(V a, V b){ return _mm256_add_pd(a, b); }
+    static V sub(V a, V b){ return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b){ return _mm256_mul_pd(a, b); }
+    static V div(V a, V b){ return _mm256_div_pd(a, b); }
+    static V sqrt(V a){ return _mm256_sqrt_pd(a); }
+    static V min(V a, V b){ return _mm256_min_pd(a, b); }
+    static V greater(V a, V b){ return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static V greaterEqual(V a, V b){ return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    static V lessEqual(V a, V b){ return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static V equal(V a, V b){ return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static V both(V a, V b){ return _mm256_and_pd(a, b); }
+    static V select(V mask, V a, V b){ return _mm256_blendv_pd(b, a, mask); }
+    static int bits(V mask){ return _mm256_movemask_pd(mask); }
+    static double lowest(V v){ return R2Sse2Lanes::lowest(_mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1))); }
+};
+#endif
+
+// single precision (see R2Scalar in vec2.h): twice the lanes in the same registers
+struct R2Sse2FloatLanes {
+    using V=__m128;
+    static constexpr int Width=4;
+    static V set1(float x){ return _mm_set1_ps(x); }
+    static V load(const float* p){ return _mm_loadu_ps(p); }
+    static void store(float* p, V v){ _mm_storeu_ps(p, v); }
+    static V add(V a, V b){ return _mm_add_ps(a, b); }
+    static V sub(V a, V b){ return _mm_sub_ps(a, b); }
+    static V mul(V a, V b){ return _mm_mul_ps(a, b); }
+    static V div(V a, V b){ return _mm_div_ps(a, b); }
+    static V sqrt(V a){ return _mm_sqrt_ps(a); }
+    static V min(V a, V b){ return _mm_min_ps(a, b); }
+    static V greater(V a, V b){ return _mm_cmpgt_ps(a, b); }
+    static V greaterEqual(V a, V b){ return _mm_cmpge_ps(a, b); }
+    static V lessEqual(V a, V b){ return _mm_cmple_ps(a, b); }
+    static V equal(V a, V b){ return _mm_cmpeq_ps(a, b); }
+    static V both(V a, V b){ return _mm_and_ps(a, b); }
+    static V select(V mask, V a, V b){ return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static int bits(V mask){ return _mm_movemask_ps(mask); }
+    static float lowest(V v){
+        V m=_mm_min_ps(v, _mm_movehl_ps(v, v));
+        return std::min(_mm_cvtss_f32(m), _mm_cvtss_f32(_mm_shuffle_ps(m, m, 1)));
+    }
+};
+
+#ifdef __AVX__
+struct R2AvxFloatLanes {
+    using V=__m256;
+    static constexpr int Width=8;
+    static V set1(float x){ return _mm256_set1_ps(x); }
+    static V load(const float* p){ return _mm256_loadu_ps(p); }
+    static void store(float* p, V v){ _mm256_storeu_ps(p, v); }
+    static V add(V a, V b){ return _mm256_add_ps(a, b); }
+    static V sub(V a, V b){ return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b){ return _mm256_mul_ps(a, b); }
+    static V div(V a, V b){ return _mm256_div_ps(a, b); }
+    static V sqrt(V a){ return _mm256_sqrt_ps(a); }
+    static V min(V a, V b){ return _mm256_min_ps(a, b); }
+    static V greater(V a, V b){ return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static V greaterEqual(V a, V b){ return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static V lessEqual(V a, V b){ return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static V equal(V a, V b){ return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static V both(V a, V b){ return _mm256_and_ps(a, b); }
+    static V select(V mask, V a, V b){ return _mm256_blendv_ps(b, a, mask); }
+    static int bits(V mask){ return _mm256_movemask_ps(mask); }
+    static float lowest(V v){ return R2Sse2FloatLanes::lowest(_mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1))); }
+};
+#endif
+
+#ifdef _R2S_FLOAT
+#ifdef __AVX__
+using R2ImpactLanes=R2AvxFloatLanes;
+#else
+using R2ImpactLanes=R2Sse2FloatLanes;
+#endif
+#else
+#ifdef __AVX__
+using R2ImpactLanes=R2AvxLanes;
+#else
+using R2ImpactLanes=R2Sse2Lanes;
+#endif
+#endif
+
+// returns the first target not computed, and the earliest time of the ones computed
+template<typename L>
+inline int impactTimesLanes(const R2ImpactTargets& targets, int first, int last, Vec2 pos, Vec2 velocity, R2Scalar rr, R2Scalar k, R2Scalar minT, R2Scalar* times, R2Scalar& earliest){
+    using V=typename L::V;
+    const V px=L::set1(pos.x), py=L::set1(pos.y), vx=L::set1(velocity.x), vy=L::set1(velocity.y);
+    const V kk=L::set1(k), radius2=L::set1(rr), lowT=L::set1(minT);
+    const V zero=L::set1(0.0), one=L::set1(1.0), two=L::set1(2.0), four=L::set1(4.0), none=L::set1(R2NoImpact);
+    V lowest=none;
+    int i=first;
+    for(; i+L::Width<=last; i+=L::Width){
+        V s2x= L::add(px, L::mul(L::sub(vx, L::load(&targets.vx[i])), kk));
+        V s2y= L::add(py, L::mul(L::sub(vy, L::load(&targets.vy[i])), kk));
+        V dx= L::sub(px, s2x);
+        V dy= L::sub(py, s2y);
+        V lx= L::sub(px, L::load(&targets.x[i]));
+        V ly= L::sub(py, L::load(&targets.y[i]));
+        V a= L::sub(L::mul(dx, dx), L::mul(dy, dy));
+        V b= L::add(L::mul(L::mul(two, dx), lx), L::mul(L::mul(two, dy), ly));
+        V c= L::sub(L::add(L::mul(lx, lx), L::mul(ly, ly)), radius2);
+        V delta= L::sub(L::mul(b, b), L::mul(L::mul(four, a), c));
+        V crossing= L::greater(delta, zero);
+        if(L::bits(crossing)==0){   // the most frequent case: none of these targets is on the way
+            L::store(times+i, none);
+            continue;
+        }
+        V deltaRoot= L::sqrt(delta);    // not a number where delta<0, those lanes are discarded below
+        V twoA= L::mul(two, a);
+        V t1= L::div(L::sub(b, deltaRoot), twoA);
+        V t2= L::div(L::add(b, deltaRoot), twoA);
+        V t= L::select(L::greaterEqual(t1, zero), t1, t2);
+        V hit= L::both(crossing, L::both(L::greaterEqual(t, lowT), L::lessEqual(t, one)));
+        t= L::select(hit, t, none);
+        L::store(times+i, t);
+        lowest= L::min(lowest, t);
+    }
+    earliest=L::lowest(lowest);
+    return i;
+}
+
+template<typename L>
+inline int earliestImpactLanes(const R2Scalar* times, int first, int last, R2Scalar& earliest){
+    if(last-first < L::Width)
+        return first;
+    typename L::V lowest=L::load(times+first);
+    int i=first+L::Width;
+    for(; i+L::Width<=last; i+=L::Width)
+        lowest=L::min(lowest, L::load(times+i));
+    earliest=std::min(earliest, L::lowest(lowest));
+    return i;
+}
+
+template<typename L>
+inline int impactTiesLanes(const R2Scalar* times, int first, int last, R2Scalar earliest, uint64_t* ties){
+    const typename L::V e=L::set1(earliest);
+    int i=first;
+    for(; i+L::Width<=last; i+=L::Width){
+        uint64_t bits=uint64_t(L::bits(L::equal(L::load(times+i), e)));
+        ties[(i-first)>>6] |= bits << ((i-first)&63);  // Width divides 64, so the bits of a step are all in the same word
+    }
+    return i;
+}
+
+#endif // R2S_IMPACT_SIMD
+
+// For each target i from first to last-1 writes in times[i] the time of impact of the circle at pos, moving with velocity
+// for the remaining 1-partialT of the tick, against the target (that moves too), when their centers are at distance radius.
+// The time is a fraction of the remaining tick, like the one given by findObjectsCollision(); it is R2NoImpact if they don't hit
+// or if it is earlier than minT. Returns the earliest of them (R2NoImpact if none).
+inline R2Scalar impactTimes(const R2ImpactTargets& targets, int first, int last, Vec2 pos, Vec2 velocity, R2Scalar radius, R2Scalar partialT, R2Scalar minT, R2Scalar* times){
+    R2Scalar rr=radius*radius;
+    R2Scalar k=1.0-partialT;
+    R2Scalar earliest=R2NoImpact;
+    int i=first;
+#ifdef R2S_IMPACT_SIMD
+    i=impactTimesLanes<R2ImpactLanes>(targets, first, last, pos, velocity, rr, k, minT, times, earliest);
+#endif
+    for(; i<last; i++){
+        times[i]=impactTime(targets, i, pos, velocity, rr, k, minT);
+        earliest=std::min(earliest, times[i]);
+    }
+    return earliest;
+}
+
+// the earliest of times[first..last-1] (R2NoImpact if empty), when some of them have been changed after impactTimes()
+inline R2Scalar earliestImpact(const R2Scalar* times, int first, int last){
+    R2Scalar earliest=R2NoImpact;
+    int i=first;
+#ifdef R2S_IMPACT_SIMD
+    i=earliestImpactLanes<R2ImpactLanes>(times, first, last, earliest);
+#endif
+    for(; i<last; i++)
+        earliest=std::min(earliest, times[i]);
+    return earliest;
+}
+
+// sets in ties the bit i-first of each of times[first..last-1] equal to earliest, clearing the others
+inline void impactTies(const R2Scalar* times, int first, int last, R2Scalar earliest, uint64_t* ties){
+    int words=(last-first+63)/64;
+    for(int w=0; w<words; w++)
+        ties[w]=0;
+    int i=first;
+#ifdef R2S_IMPACT_SIMD
+    i=impactTiesLanes<R2ImpactLanes>(times, first, last, earliest, ties);
+#endif
+    for(; i<last; i++)
+        if(times[i]==earliest)
+            ties[(i-first)>>6] |= uint64_t(1) << ((i-first)&63);
+}
+
+// calls f(i) for each bit i set in the first count bits of ties, in increasing order
+template<typename F>
+inline void forEachTie(const uint64_t* ties, int count, const F& f){
+    for(int w=0; w<(count+63)/64; w++)
+        for(uint64_t bits=ties[w]; bits; bits&=bits-1)
+            f(w*64+lowestBit(bits));
+}
+
+} // end namespace
+
+#endif // R2S_IMPACT_KERNEL_H
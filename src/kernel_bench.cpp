@@ -0,0 +1,326 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d_kernel_bench: micro-benchmarks of the collision functions on crafted game situations, with JSON output
+#include "simulator.h"
+
+using namespace std;
+using namespace r2s;
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+namespace r2s {
+
+// gives access to the private collision functions of R2Simulator
+struct R2KernelBench {
+    static R2Environment& env(R2Simulator& sim) { return sim.env; }
+    static const R2EnvSettings& settings(R2Simulator& sim) { return sim.sett; }
+
+    static std::tuple<bool, double> findObjectsCollision(R2Simulator& sim, R2ObjectInfo& obj1, R2ObjectInfo& obj2, double radius, double partialT){
+        return sim.findObjectsCollision(obj1, obj2, radius, partialT);
+    }
+    static size_t findFirstBallPlayersCollisions(R2Simulator& sim, double partialT, std::vector<bool>& ballPlayerBlacklist){
+        sim.findFirstBallPlayersCollisions(partialT, ballPlayerBlacklist, sim.firstBallPlayerColls);
+        return sim.firstBallPlayerColls.size();
+    }
+    static size_t findFirstPlayerPlayersCollisions(R2Simulator& sim, double partialT, std::vector<int>& playerPlayerCollisions){
+        sim.findFirstPlayerPlayersCollisions(partialT, playerPlayerCollisions, sim.firstPlayerPlayerColls);
+        return sim.firstPlayerPlayerColls.size();
+    }
+    static size_t findFirstPolePlayersCollisions(R2Simulator& sim, double partialT){
+        sim.findFirstPolePlayersCollisions(partialT, sim.firstPolePlayersColls);
+        return sim.firstPolePlayersColls.size();
+    }
+    static bool findFirstPoleBallCollision(R2Simulator& sim, double partialT){
+        return sim.findFirstPoleBallCollision(partialT).collision;
+    }
+    static unsigned possibleCollisions(R2Simulator& sim) { return sim.possibleCollisions(); }
+    static void manageCollisions(R2Simulator& sim) { sim.manageCollisions(); }
+    static void manageStaticPlayersCollisions(R2Simulator& sim) { sim.manageStaticPlayersCollisions(); }
+};
+
+} // end namespace
+
+// agents are never asked to act here
+class IdlePlayer : public R2Player {
+public:
+  IdlePlayer(int, int) {}   // the signature required by buildSimulator()
+  virtual R2Action step(const R2GameState) override { return R2Action(); }
+};
+
+struct Fixture {
+  string name;
+  R2ObjectInfo ball;
+  vector<R2PlayerInfo> teams[2];
+};
+
+constexpr int FixturePlayers=11;
+
+// players running towards a point at the given speed, with direction matching their velocity
+static R2PlayerInfo runningPlayer(double x, double y, double targetX, double targetY, double speed){
+  Vec2 d(targetX-x, targetY-y);
+  double direction=atan2(d.y, d.x);
+  if(d.len()>0.0)
+    d.resize(speed);
+  return R2PlayerInfo(x, y, d.x, d.y, direction);
+}
+
+// the positions are jittered with a fixed seed, so that fixtures are always the same
+static vector<Fixture> buildFixtures(const R2EnvSettings& sett){
+  vector<Fixture> fixtures;
+  std::mt19937 gen(2021);
+  std::uniform_real_distribution<double> jitter(-0.15, 0.15);
+  double halfLength=sett.pitchLength/2.0;
+  double halfWidth=sett.pitchWidth/2.0;
+  double speed=MaxPlayerSpeed;
+
+  // players spread on the whole pitch, running in different directions, the ball far from everybody
+  Fixture open;
+  open.name="open_field";
+  for(int t=0; t<=1; t++){
+    double side= t ? 1.0 : -1.0;
+    for(int i=0; i<FixturePlayers; i++){
+      double x=side*halfLength*(0.1 + 0.8*double(i%4)/3.0) + jitter(gen);
+      double y=halfWidth*(-0.75 + 0.5*double(i/4)) + jitter(gen);
+      double angle= (i*7+t*3)*0.9;
+      open.teams[t].push_back(R2PlayerInfo(x, y, cos(angle)*speed, sin(angle)*speed, angle));
+    }
+  }
+  open.ball=R2ObjectInfo(0.0, halfWidth*0.9, MaxBallSpeed*0.8, 0.0);
+  fixtures.push_back(open);
+
+  // everybody in front of the right goal, the ball running fast among players and poles
+  Fixture goalMouth;
+  goalMouth.name="crowded_goal_mouth";
+  double goalY=sett.goalWidth/2.0;
+  for(int t=0; t<=1; t++){
+    for(int i=0; i<FixturePlayers; i++){
+      double x=halfLength - 0.45 - (i%4)*0.85 - t*0.4 + jitter(gen);
+      double y=-goalY - 0.4 + (i/4)*(goalY+0.4) + t*0.45 + jitter(gen);
+      goalMouth.teams[t].push_back(runningPlayer(x, y, halfLength, 0.0, speed));
+    }
+  }
+  goalMouth.ball=R2ObjectInfo(halfLength-1.0, goalY-0.3, MaxBallSpeed, MaxBallSpeed*0.5);
+  fixtures.push_back(goalMouth);
+
+  // all players squeezed around the ball, running towards it
+  Fixture scrum;
+  scrum.name="scrum";
+  double contact=sett.playerRadius+sett.ballRadius;
+  for(int t=0; t<=1; t++){
+    for(int i=0; i<FixturePlayers; i++){
+      int k=t*FixturePlayers+i;
+      double radius= (k<8) ? contact+0.05 : contact+0.85;
+      double angle= (k<8) ? k*M_PI/4.0 : (k-8)*2.0*M_PI/14.0 + 0.1;
+      scrum.teams[t].push_back(runningPlayer(cos(angle)*radius, sin(angle)*radius, 0.0, 0.0, speed));
+    }
+  }
+  scrum.ball=R2ObjectInfo(0.0, 0.0, MaxBallSpeed*0.7, MaxBallSpeed*0.3);
+  fixtures.push_back(scrum);
+
+  // the two teams lined up in their halves, running towards the ball still in the center
+  Fixture kickoff;
+  kickoff.name="kickoff";
+  for(int t=0; t<=1; t++){
+    double side= t ? 1.0 : -1.0;
+    for(int i=0; i<FixturePlayers; i++){
+      double x= (i==0) ? side*(halfLength-0.5) : side*(sett.centerRadius + 0.5 + ((i-1)%3)*halfLength/4.0);
+      double y= (i==0) ? 0.0 : halfWidth*(-0.6 + 0.4*double((i-1)/3));
+      kickoff.teams[t].push_back(runningPlayer(x, y, 0.0, 0.0, (i==0) ? 0.0 : speed));
+    }
+  }
+  kickoff.ball=R2ObjectInfo(0.0, 0.0, 0.0, 0.0);
+  fixtures.push_back(kickoff);
+
+  return fixtures;
+}
+
+static void restore(R2Simulator& sim, const Fixture& f){
+  sim.setEnvironment(100, 0, 0, R2State::Play, f.ball, f.teams[0], f.teams[1], false, 0, false);
+}
+
+// median of some batches, in nanoseconds per operation. Each call of f performs opsPerCall operations.
+static double timeNs(const function<void()>& f, int opsPerCall, double minSeconds){
+  using clock=chrono::steady_clock;
+  long long calls=1;
+  for(;;){  // calibration: a batch should last at least a fifth of minSeconds
+    auto start=clock::now();
+    for(long long i=0; i<calls; i++)
+      f();
+    double elapsed=chrono::duration<double>(clock::now()-start).count();
+    if(elapsed >= minSeconds/5.0)
+      break;
+    calls*=2;
+  }
+  vector<double> batches;
+  for(int b=0; b<5; b++){
+    auto start=clock::now();
+    for(long long i=0; i<calls; i++)
+      f();
+    batches.push_back(chrono::duration<double, nano>(clock::now()-start).count()/double(calls*opsPerCall));
+  }
+  sort(batches.begin(), batches.end());
+  return batches[2];
+}
+
+static volatile double sink;  // keeps the compiler from discarding the results
+
+static void usage(){
+  cout << "usage: robosoc2d_kernel_bench [--min-time SECONDS] [--output FILE]" << endl;
+}
+
+int main(int argc, char** argv)
+{
+  double minSeconds=0.5;
+  string output;
+  for(int i=1; i<argc; i++){
+    bool hasValue= (i+1<argc);
+    if((strcmp(argv[i], "--min-time")==0) && hasValue)
+      minSeconds=stod(argv[++i]);
+    else if((strcmp(argv[i], "--output")==0) && hasValue)
+      output=argv[++i];
+    else{
+      usage();
+      return 1;
+    }
+  }
+
+  auto simulator= buildSimulator<IdlePlayer,IdlePlayer>(FixturePlayers, FixturePlayers, defaultTeam1Name, defaultTeam2Name, 1);
+  R2Simulator& sim= *simulator;
+  const R2EnvSettings sett=R2KernelBench::settings(sim);
+  vector<Fixture> fixtures=buildFixtures(sett);
+
+  ostringstream json;
+  json.precision(6);
+  json << "{\n";
+  json << "  \"version\": \"" << R2SVersion << "\",\n";
+#if defined(__OPTIMIZE__) || defined(NDEBUG)
+  json << "  \"optimized\": true,\n";
+#else
+  json << "  \"optimized\": false,\n";
+#endif
+  json << "  \"players\": " << FixturePlayers*2 << ",\n";
+  json << "  \"fixtures\": [\n";
+
+  for(size_t f=0; f<fixtures.size(); f++){
+    const Fixture& fixture=fixtures[f];
+    restore(sim, fixture);
+    R2Environment& env=R2KernelBench::env(sim);
+
+    // all the moving pairs checked in a tick: ball-player and player-player
+    vector<pair<R2ObjectInfo*, R2ObjectInfo*>> pairs;
+    vector<double> radiuses;
+    vector<R2ObjectInfo*> objects;
+    for(int t=0; t<=1; t++)
+      for(auto& p : env.teams[t])
+        objects.push_back(&p);
+    for(auto p : objects){
+      pairs.push_back({&env.ball, p});
+      radiuses.push_back(sett.ballRadius+sett.playerRadius);
+    }
+    for(size_t i=0; i<objects.size(); i++)
+      for(size_t j=i+1; j<objects.size(); j++){
+        pairs.push_back({objects[i], objects[j]});
+        radiuses.push_back(sett.playerRadius*2);
+      }
+    int nPairs=pairs.size();
+
+    struct Segment { Vec2 s1, s2, c; double r; };
+    vector<Segment> segments;
+    for(int i=0; i<nPairs; i++){
+      auto [o1, o2]=pairs[i];
+      segments.push_back(Segment{o1->pos, o1->pos + (o1->velocity - o2->velocity), o2->pos, radiuses[i]});
+    }
+
+    vector<bool> ballPlayerBlacklist(FixturePlayers*2, false);
+    vector<int> playerPlayerCollisions(FixturePlayers*2, -1);
+
+    vector<pair<string, double>> results;
+    results.push_back({"intersection_segment_circle", timeNs([&](){
+      double acc=0.0;
+      for(auto& s : segments){
+        auto [n, t1, t2]=intersectionSegmentCircle(s.s1, s.s2, s.c, s.r);
+        acc+= n+t1;
+      }
+      sink=acc;
+    }, nPairs, minSeconds)});
+    results.push_back({"find_objects_collision", timeNs([&](){
+      double acc=0.0;
+      for(int i=0; i<nPairs; i++){
+        auto [found, t]=R2KernelBench::findObjectsCollision(sim, *pairs[i].first, *pairs[i].second, radiuses[i], 0.0);
+        acc+= found ? t : 0.0;
+      }
+      sink=acc;
+    }, nPairs, minSeconds)});
+    results.push_back({"find_first_ball_players_collisions", timeNs([&](){
+      sink=R2KernelBench::findFirstBallPlayersCollisions(sim, 0.0, ballPlayerBlacklist);
+    }, 1, minSeconds)});
+    results.push_back({"find_first_player_players_collisions", timeNs([&](){
+      sink=R2KernelBench::findFirstPlayerPlayersCollisions(sim, 0.0, playerPlayerCollisions);
+    }, 1, minSeconds)});
+    results.push_back({"find_first_pole_players_collisions", timeNs([&](){
+      sink=R2KernelBench::findFirstPolePlayersCollisions(sim, 0.0);
+    }, 1, minSeconds)});
+    results.push_back({"find_first_pole_ball_collision", timeNs([&](){
+      sink=R2KernelBench::findFirstPoleBallCollision(sim, 0.0);
+    }, 1, minSeconds)});
+    results.push_back({"possible_collisions", timeNs([&](){
+      sink=R2KernelBench::possibleCollisions(sim);
+    }, 1, minSeconds)});
+
+    // the following ones modify the environment, so it has to be restored before each call: its cost is measured and subtracted
+    double restoreNs=timeNs([&](){ restore(sim, fixture); }, 1, minSeconds);
+    R2PhysicsCounters before=sim.getPhysicsCounters();
+    double manageNs=timeNs([&](){ restore(sim, fixture); R2KernelBench::manageCollisions(sim); }, 1, minSeconds);
+    R2PhysicsCounters after=sim.getPhysicsCounters();
+    results.push_back({"manage_collisions", max(0.0, manageNs-restoreNs)});
+    sim.setEventDrivenCollisions(true);
+    results.push_back({"manage_collisions_event_driven", max(0.0, timeNs([&](){ restore(sim, fixture); R2KernelBench::manageCollisions(sim); }, 1, minSeconds)-restoreNs)});
+    sim.setEventDrivenCollisions(false);
+    results.push_back({"manage_static_players_collisions", max(0.0, timeNs([&](){ restore(sim, fixture); R2KernelBench::manageStaticPlayersCollisions(sim); }, 1, minSeconds)-restoreNs)});
+    sim.setStaticRelaxation(0.0);
+    results.push_back({"manage_static_players_collisions_exact", max(0.0, timeNs([&](){ restore(sim, fixture); R2KernelBench::manageStaticPlayersCollisions(sim); }, 1, minSeconds)-restoreNs)});
+    sim.setStaticRelaxation(StaticTolerance);
+
+    long long loops=0, calls=0;
+    for(int n=0; n<=MaxCollisionInsideTickLoop; n++){
+      long long c=after.subSteps[n]-before.subSteps[n];
+      calls+=c;
+      loops+=c*n;
+    }
+    int capHits=after.collisionsLoopCapHits-before.collisionsLoopCapHits;
+
+    cerr << fixture.name << endl;
+    json << "    {\"name\": \"" << fixture.name << "\", \"pairs\": " << nPairs
+      << ", \"restore_ns\": " << restoreNs
+      << ", \"manage_collisions_mean_sub_steps\": " << (calls ? double(loops)/double(calls) : 0.0)
+      << ", \"manage_collisions_cap_hit_ratio\": " << (calls ? double(capHits)/double(calls) : 0.0)
+      << ",\n     \"kernels_ns\": {";
+    for(size_t r=0; r<results.size(); r++){
+      json << (r ? ", " : "") << "\"" << results[r].first << "\": " << results[r].second;
+      cerr << "  " << results[r].first << ": " << results[r].second << " ns" << endl;
+    }
+    json << "}}" << ((f+1<fixtures.size()) ? "," : "") << "\n";
+  }
+  json << "  ]\n}\n";
+
+  if(output.empty()){
+    cout << json.str();
+  }
+  else{
+    ofstream file(output);
+    if(!file.is_open()){
+      cerr << "unable to write " << output << endl;
+      return 1;
+    }
+    file << json.str();
+  }
+  return 0;
+}
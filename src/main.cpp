@@ -21,6 +21,9 @@ int main(int argc, char** argv)
 
   cout << "Very Simplified 2D Robotic Soccer Simulator" << endl;
   std::unique_ptr<R2Simulator> simulator=  buildSimulator<SimplePlayer,SimplePlayer>(nPlayers1, nPlayers2, defaultTeam1Name, defaultTeam2Name, random_seed);
+#if defined(_DEBUG) || defined(_R2S_DEBUG)
+  simulator->setAgentLatencyTracking(true);   // reported at the end of the match
+#endif
   
   char status_msg[256];
   DEBUG_OUT("\n random seed:");
@@ -35,6 +38,8 @@ int main(int argc, char** argv)
   strcpy(status_msg, simulator->getStateString().c_str() ); // to show also what happened in last tick
   DEBUG_OUT(status_msg);
   DEBUG_OUT("\n");
+  if(simulator->isAgentLatencyTracking())
+    DEBUG_OUT(simulator->getAgentLatencyString());
   //simulator->saveHistory();
 }
 
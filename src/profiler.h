@@ -0,0 +1,225 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d : opt-in timers of the simulator phases, with per-tick latency histograms
+#ifndef R2S_PROFILER_H
+#define R2S_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+
+// Timing is compiled only if _R2S_PROFILE is #defined (CMake: -DROBOSOC2D_PROFILE=ON, or "g++ -D _R2S_PROFILE").
+// Otherwise the macros below are empty and the profile of the simulator just stays at zero.
+// Heap allocations are counted only in the executables that replace the global operator new including "alloc_counter.h".
+
+namespace r2s {
+
+enum class R2Phase {
+    PreState,
+    PlayersAct,                     //!< the whole playersAct(), including the two phases below
+    PlayersAgents,                  //!< agents choosing their actions (game state copy included)
+    PlayersProcessStep,             //!< actions processing
+    ManageCollisions,               //!< moving objects and solving their collisions during play
+    ManageStaticPlayersCollisions,  //!< separating overlapping players
+    CheckState,                     //!< the whole checkState(), including the two phases above
+    DecaySpeed,
+    History,                        //!< environment recording in history
+    Count
+};
+
+constexpr int R2PhaseCount=int(R2Phase::Count);
+
+inline const char* getPhaseName(R2Phase phase){
+    static const char* names[R2PhaseCount]={"pre_state", "players_act", "players_agents", "players_process_step",
+        "manage_collisions", "manage_static_players_collisions", "check_state", "decay_speed", "history"};
+    return names[int(phase)];
+}
+
+// log-linear histogram of nanoseconds values: exact below 16ns, then 8 buckets for each power of 2 (values are known with 12.5% resolution).
+// It has fixed size, so adding values never allocates.
+struct R2LatencyHistogram {
+    static constexpr int SubBits=3;
+    static constexpr int SubBuckets=1<<SubBits;
+    static constexpr int LinearBuckets=SubBuckets*2;
+    static constexpr int Buckets=LinearBuckets + (64-SubBits-1)*SubBuckets;
+
+    uint64_t counts[Buckets];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    R2LatencyHistogram() { clear(); }
+
+    void clear(){
+        std::fill(std::begin(counts), std::end(counts), 0);
+        count=0; sum=0; max=0;
+    }
+
+    static int bucketOf(uint64_t ns){
+        if(ns<LinearBuckets)
+            return int(ns);
+        int e=SubBits+1;
+        while((ns>>(e+1)) != 0)
+            e++;
+        return LinearBuckets + (e-SubBits-1)*SubBuckets + int((ns>>(e-SubBits)) & (SubBuckets-1));
+    }
+
+    static uint64_t bucketLowerBound(int bucket){
+        if(bucket<LinearBuckets)
+            return uint64_t(bucket);
+        int k=bucket-LinearBuckets;
+        int e=k/SubBuckets + SubBits + 1;
+        return uint64_t(SubBuckets + k%SubBuckets) << (e-SubBits);
+    }
+
+    void add(uint64_t ns){
+        counts[bucketOf(ns)]++;
+        count++;
+        sum+=ns;
+        if(ns>max)
+            max=ns;
+    }
+
+    // value (in nanoseconds) below which there is the fraction p of the samples. It's the middle of its bucket, never above max.
+    uint64_t percentile(double p) const {
+        if(count==0)
+            return 0;
+        uint64_t target= uint64_t(p*double(count));
+        if(target<1)
+            target=1;
+        uint64_t cumulated=0;
+        for(int b=0; b<Buckets; b++){
+            cumulated+=counts[b];
+            if(cumulated>=target){
+                uint64_t low=bucketLowerBound(b);
+                uint64_t high= (b+1<Buckets) ? bucketLowerBound(b+1) : low;
+                return std::min(low+(high-low)/2, max);
+            }
+        }
+        return max;
+    }
+
+    double mean() const { return (count>0) ? double(sum)/double(count) : 0.0; }
+};
+
+// heap allocations made by the whole program. They stay at zero unless "alloc_counter.h" is included by one of its source files.
+struct R2Allocations {
+    static inline std::atomic<uint64_t> count{0};
+    static inline std::atomic<uint64_t> bytes{0};
+    static inline bool counted=false;  //!< true if the global operator new counting them is linked
+
+    static uint64_t now(){ return count.load(std::memory_order_relaxed); }
+};
+
+struct R2PhaseStats {
+    uint64_t totalNs;   //!< accumulated time
+    uint64_t calls;     //!< how many times the phase has been run
+    R2LatencyHistogram perTick; //!< time spent in the phase in each tick, only for the ticks in which it has been run
+    uint64_t allocations;   //!< heap allocations made inside the phase
+    uint64_t maxTickAllocations;    //!< most heap allocations made inside the phase in a single tick
+    uint64_t allocatingTicks;   //!< ticks in which the phase allocated
+
+    R2PhaseStats() : totalNs(0), calls(0), perTick(), allocations(0), maxTickAllocations(0), allocatingTicks(0) {}
+    void clear(){ totalNs=0; calls=0; perTick.clear(); allocations=0; maxTickAllocations=0; allocatingTicks=0; }
+};
+
+struct R2Profile {
+    R2PhaseStats phases[R2PhaseCount];
+    R2LatencyHistogram ticks;   //!< duration of the whole step()
+    uint64_t allocations;   //!< heap allocations made inside step()
+    uint64_t maxTickAllocations;
+    uint64_t allocatingTicks;
+    uint64_t tickNs[R2PhaseCount];  // current tick accumulators
+    uint64_t tickAllocations[R2PhaseCount];
+    bool tickRun[R2PhaseCount];
+
+    R2Profile() { clear(); }
+
+    void clear(){
+        for(auto& p : phases)
+            p.clear();
+        ticks.clear();
+        allocations=0; maxTickAllocations=0; allocatingTicks=0;
+        std::fill(std::begin(tickNs), std::end(tickNs), 0);
+        std::fill(std::begin(tickAllocations), std::end(tickAllocations), 0);
+        std::fill(std::begin(tickRun), std::end(tickRun), false);
+    }
+
+    void addPhase(R2Phase phase, uint64_t ns, uint64_t allocs){
+        int i=int(phase);
+        phases[i].totalNs+=ns;
+        phases[i].calls++;
+        phases[i].allocations+=allocs;
+        tickNs[i]+=ns;
+        tickAllocations[i]+=allocs;
+        tickRun[i]=true;
+    }
+
+    void addTick(uint64_t ns, uint64_t allocs){
+        ticks.add(ns);
+        allocations+=allocs;
+        maxTickAllocations=std::max(maxTickAllocations, allocs);
+        allocatingTicks+= (allocs>0);
+        for(int i=0; i<R2PhaseCount; i++){
+            if(tickRun[i]){
+                phases[i].perTick.add(tickNs[i]);
+                phases[i].maxTickAllocations=std::max(phases[i].maxTickAllocations, tickAllocations[i]);
+                phases[i].allocatingTicks+= (tickAllocations[i]>0);
+            }
+            tickNs[i]=0;
+            tickAllocations[i]=0;
+            tickRun[i]=false;
+        }
+    }
+
+    static constexpr bool enabled(){
+#ifdef _R2S_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+};
+
+// time taken by an agent (or by a whole team) to choose its actions. The times are recorded only if enabled by
+// R2Simulator::setAgentLatencyTracking(), the overruns whenever a step time budget is set (see R2Simulator::setStepTimeBudget()).
+struct R2AgentLatency {
+    R2LatencyHistogram latency;
+    uint64_t overruns;  //!< steps that took longer than the step time budget, whose actions have been replaced by NoOp
+
+    R2AgentLatency() : latency(), overruns(0) {}
+    void clear(){ latency.clear(); overruns=0; }
+};
+
+class R2PhaseTimer {
+    R2Profile& profile;
+    R2Phase phase;
+    std::chrono::steady_clock::time_point start;
+    uint64_t startAllocations;
+public:
+    R2PhaseTimer(R2Profile& _profile, R2Phase _phase) : profile(_profile), phase(_phase), start(std::chrono::steady_clock::now()), startAllocations(R2Allocations::now()) {}
+    ~R2PhaseTimer(){ profile.addPhase(phase, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count()), R2Allocations::now()-startAllocations); }
+};
+
+class R2TickTimer {
+    R2Profile& profile;
+    std::chrono::steady_clock::time_point start;
+    uint64_t startAllocations;
+public:
+    R2TickTimer(R2Profile& _profile) : profile(_profile), start(std::chrono::steady_clock::now()), startAllocations(R2Allocations::now()) {}
+    ~R2TickTimer(){ profile.addTick(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count()), R2Allocations::now()-startAllocations); }
+};
+
+} // end namespace
+
+// to be used at most once per scope, inside R2Simulator methods
+#ifdef _R2S_PROFILE
+#define R2S_PROFILE_PHASE(phase) r2s::R2PhaseTimer r2sPhaseTimer(profile, phase)
+#define R2S_PROFILE_TICK() r2s::R2TickTimer r2sTickTimer(profile)
+#else
+#define R2S_PROFILE_PHASE(phase)
+#define R2S_PROFILE_TICK()
+#endif
+
+#endif // R2S_PROFILER_H
@@ -0,0 +1,131 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d : counter-based random numbers, reproducible whatever the order in which they are drawn
+#ifndef R2S_RANDOM_H
+#define R2S_RANDOM_H
+
+#include <cstdint>
+#include <cmath>
+
+// Every number is a pure function of (seed, tick, stream, index): there is no sequential state to share between threads,
+// and it does not depend on the standard library implementation (unlike std::default_random_engine and std:: distributions).
+// Uniform numbers use only integer arithmetic. Normal numbers use a ziggurat whose tables are built once with std::exp()
+// and std::log(), so they are the same on all the platforms whose math library rounds those correctly.
+
+namespace r2s {
+
+// Philox4x32-10, from: J. Salmon, M. Moraes, R. Dror, D. Shaw, "Parallel random numbers: as easy as 1, 2, 3" (SC 2011)
+inline void philox4x32(uint32_t ctr[4], uint32_t k0, uint32_t k1){
+    const uint32_t M0=0xD2511F53, M1=0xCD9E8D57;
+    const uint32_t W0=0x9E3779B9, W1=0xBB67AE85;
+    for(int round=0; round<10; round++){
+        uint64_t p0=uint64_t(M0)*ctr[0];
+        uint64_t p1=uint64_t(M1)*ctr[2];
+        uint32_t c0=uint32_t(p1>>32) ^ ctr[1] ^ k0;
+        uint32_t c2=uint32_t(p0>>32) ^ ctr[3] ^ k1;
+        ctr[1]=uint32_t(p1);
+        ctr[3]=uint32_t(p0);
+        ctr[0]=c0;
+        ctr[2]=c2;
+        k0+=W0;
+        k1+=W1;
+    }
+}
+
+// 128 layers ziggurat tables for the standard normal distribution (G. Marsaglia, W. Tsang, "The ziggurat method
+// for generating random variables", 2000; with J. Doornik's improvements, "An improved ziggurat method to generate normal random samples", 2005)
+struct R2ZigguratTables {
+    static constexpr int Layers=128;
+    static constexpr double R=3.442619855899;   // start of the tail
+    static constexpr double V=9.91256303526217e-3;  // area of each layer
+    double x[Layers+1];
+    double ratio[Layers];
+
+    R2ZigguratTables(){
+        double f=std::exp(-0.5*R*R);
+        x[0]=V/f;
+        x[1]=R;
+        x[Layers]=0.0;
+        for(int i=2; i<Layers; i++){
+            x[i]=std::sqrt(-2.0*std::log(V/x[i-1] + f));
+            f=std::exp(-0.5*x[i]*x[i]);
+        }
+        for(int i=0; i<Layers; i++)
+            ratio[i]=x[i+1]/x[i];
+    }
+
+    static const R2ZigguratTables& get(){
+        static const R2ZigguratTables tables;
+        return tables;
+    }
+};
+
+class R2CounterRandom {
+    uint32_t key0, key1;
+
+    // the sub-th block of 128 bits of a draw, as two 64 bits words
+    void block(uint32_t tick, uint32_t stream, uint32_t index, uint32_t sub, uint64_t& a, uint64_t& b) const {
+        uint32_t ctr[4]={tick, stream, index, sub};
+        philox4x32(ctr, key0, key1);
+        a= (uint64_t(ctr[0])<<32) | ctr[1];
+        b= (uint64_t(ctr[2])<<32) | ctr[3];
+    }
+
+    static double toUnit(uint64_t bits){ return double(bits>>11)*(1.0/9007199254740992.0); }  // [0,1)
+    static double toUnitNonZero(uint64_t bits){ return double((bits>>11)+1)*(1.0/9007199254740992.0); }  // (0,1]
+
+public:
+    R2CounterRandom(uint64_t seed=0) { setSeed(seed); }
+    void setSeed(uint64_t seed){ key0=uint32_t(seed); key1=uint32_t(seed>>32) ^ 0x5EED5EED; }
+
+    // uniform in [0,1)
+    double uniform(uint32_t tick, uint32_t stream, uint32_t index) const {
+        uint64_t a, b;
+        block(tick, stream, index, 0, a, b);
+        return toUnit(a);
+    }
+
+    // uniform integer in [0,n), without bias (D. Lemire, "Fast random integer generation in an interval", 2019)
+    uint32_t uniformInt(uint32_t n, uint32_t tick, uint32_t stream, uint32_t index) const {
+        uint32_t threshold= uint32_t(-n) % n;
+        for(uint32_t sub=0; ; sub++){
+            uint32_t ctr[4]={tick, stream, index, sub};
+            philox4x32(ctr, key0, key1);
+            for(uint32_t x : ctr){
+                uint64_t m=uint64_t(x)*n;
+                if(uint32_t(m) >= threshold)
+                    return uint32_t(m>>32);
+            }
+        }
+    }
+
+    // standard normal (mean 0, standard deviation 1), with a ziggurat: most of the times a single block and a multiplication
+    double normal(uint32_t tick, uint32_t stream, uint32_t index) const {
+        const R2ZigguratTables& z=R2ZigguratTables::get();
+        for(uint32_t sub=0; ; sub+=2){
+            uint64_t a, b;
+            block(tick, stream, index, sub, a, b);
+            int i= int(a & (R2ZigguratTables::Layers-1));
+            double u= 2.0*toUnit(a) - 1.0;  // the low bits used for i are discarded by toUnit()
+            if(std::fabs(u) < z.ratio[i])
+                return u*z.x[i];
+            if(i==0){   // tail
+                for(uint32_t tailSub=sub+1; ; tailSub+=2){
+                    block(tick, stream, index, tailSub, a, b);
+                    double x= std::log(toUnitNonZero(a))/R2ZigguratTables::R;
+                    double y= std::log(toUnitNonZero(b));
+                    if(-2.0*y >= x*x)
+                        return (u<0.0) ? x-R2ZigguratTables::R : R2ZigguratTables::R-x;
+                }
+            }
+            double x=u*z.x[i];
+            double f0=std::exp(-0.5*(z.x[i]*z.x[i] - x*x));
+            double f1=std::exp(-0.5*(z.x[i+1]*z.x[i+1] - x*x));
+            if(f1 + toUnit(b)*(f0-f1) < 1.0)
+                return x;
+        }
+    }
+};
+
+} // end namespace
+
+#endif // R2S_RANDOM_H
@@ -35,9 +35,17 @@ namespace r2s {
 
 SimplePlayer::SimplePlayer(int index, int _whichTeam) : shirtNumber(index), team(_whichTeam),
  normalEnv(), env(), prevAction(), prevState(R2State::Inactive),
- uniformDist(0.0, 1.0), rng (42), cosKickableAngle(0.0), cosCatchableAngle(0.0) {
+ uniformDist(0.0, 1.0), rng (42), cosKickableAngle(0.0), cosCatchableAngle(0.0), assignments() {
 };
 
+// the memory of the previous step and the random generator, as at construction. The rest is overwritten at each step.
+void SimplePlayer::reset(){
+    prevAction=R2Action();
+    prevState=R2State::Inactive;
+    uniformDist.reset();
+    rng.seed(42);
+}
+
 R2Action  SimplePlayer::transformActionIfNecessary(R2Action action){
     if((team && (!env.halftimePassed) ) || ( (!team) && env.halftimePassed)){
         switch(action.action){
@@ -207,7 +215,7 @@ double SimplePlayer::angleTowardPoint(double x, double y){
     double dy=y - p.pos.y;
     if((dx==0.0)&&(dy==0.0))
         return 0.0;
-    return atan2(dy,dx);
+    return fatan2(dy,dx);
 }
 
 double SimplePlayer::angleTowardBall(){
@@ -239,7 +247,7 @@ double SimplePlayer::ballAngleTowardPoint(double x, double y){
     double dy=y - env.ball.pos.y;
     if((dx==0.0)&&(dy==0.0))
         return 0.0;
-    return atan2(dy,dx);
+    return fatan2(dy,dx);
 }
 
 double SimplePlayer::ballAngleTowardCompanion(int companion){
@@ -274,7 +282,7 @@ bool SimplePlayer::isBallKickable(){
 
     // is ball in front of player? only when not in kicking from restart game.
     if( (!sett.simplified) && (!isTeamResumeKicking()) && (fabs(dist)>R2SmallEpsilon) ){
-        double cosinusPlayerBall= (d.x*cos(p.direction) + d.y*sin(p.direction))/dist;
+        double cosinusPlayerBall= (d.x*fcos(p.direction) + d.y*fsin(p.direction))/dist;
         if(cosinusPlayerBall <= cosKickableAngle)  
             return false;
     }
@@ -310,7 +318,7 @@ bool SimplePlayer::isOpponentCloserToBall(){
 }
 
 // except goalkeeper
-int SimplePlayer::playerClosestToBall(std::vector<R2PlayerInfo>& team){
+int SimplePlayer::playerClosestToBall(R2Team& team){
     int closest =1;
     if (team.size() < 2)
         return 0;
@@ -376,7 +384,7 @@ int SimplePlayer::myClosestCompanion(){
     return closest;
 }
 
-int SimplePlayer::myPlayerClosestToOpponent(int opponent, std::vector<int> assigned){
+int SimplePlayer::myPlayerClosestToOpponent(int opponent, const std::vector<int>& assigned){
     Vec2 pos=env.teams[1][opponent].pos;
     int closest =-1;
     double minDist=1000000.0;
@@ -449,7 +457,7 @@ double SimplePlayer::companionPassValue(int player, bool advanced){
     Vec2 d=pos -env.ball.pos;
     double angle=0.0;
     if( (!sett.simplified) && (d.x!=0.0)&&(d.y!=0.0)){
-        angle=atan2(d.y,d.x);
+        angle=fatan2(d.y,d.x);
         if(!isTeamResumeKicking()){
             auto& p=env.teams[0][shirtNumber];
             double a=fixAnglePositive(angle);
@@ -700,7 +708,7 @@ R2Action SimplePlayer::positionPlayer(){
 
         if((env.ball.pos.x < goBackThresholdDistance) || (opponentBaricenter().dist(Vec2(pitch.x2,0.0))>goBackBaricenterThresholdDistance) ){
             // assign an opponent to mark. 0 is unassigned (you don't mark the goalkeepr), -1 is ball or no opponent. Goalkeeper is not marking, opponent goalkeeper is not marked
-            std::vector<int> assignments(env.teams[0].size(), 0);
+            assignments.assign(env.teams[0].size(), 0);
             int busy=myPlayerClosestToBall();    // this one is busy reaching for the ball
             assignments[busy]=-1;
             assignments[0]=-1;  //goalkeeper
@@ -772,7 +780,7 @@ R2Action SimplePlayer::positionGoalkeeper(){
                     angle=-M_PI_2;
             }
             else {
-                angle=atan2(posDiff.y, posDiff.x);
+                angle=fatan2(posDiff.y, posDiff.x);
             }
 
             double dashPower=sett.maxDashPower;
@@ -798,7 +806,7 @@ R2Action SimplePlayer::playGoalkeeper(){
     auto p= env.teams[0][shirtNumber];
     auto [dist, d]=p.dist(env.ball); 
 
-    double cosinusPlayerBall= (d.x*cos(p.direction) + d.y*sin(p.direction))/dist;
+    double cosinusPlayerBall= (d.x*fcos(p.direction) + d.y*fsin(p.direction))/dist;
 
     if( (dist<sett.kickableDistance) &&
         (cosinusPlayerBall >= cosKickableAngle)  ){
@@ -18,9 +18,10 @@ private:
     R2Action prevAction;
     R2State prevState;
     std::uniform_real_distribution<double> uniformDist;
-    std::default_random_engine rng;
+    std::minstd_rand0 rng;  // std::default_random_engine on libstdc++, but the same with every standard library
     double cosKickableAngle;
     double cosCatchableAngle;
+    std::vector<int> assignments;   // the opponents marked by the players, kept to not allocate it at each step
 
     double minOpponentSegmentDistance(Vec2 s1, Vec2 s2);
     Vec2 calcAdvancedPosition(int player);
@@ -50,12 +51,12 @@ private:
     bool isOpponentCloserToBall();
     Vec2 opponentBaricenter();
 
-    int playerClosestToBall(std::vector<R2PlayerInfo> & team);
+    int playerClosestToBall(R2Team& team);
     int myPlayerClosestToBall();
     int opponentPlayerClosestToBall();
     int myClosestOpponent();
     int myClosestCompanion();
-    int myPlayerClosestToOpponent(int opponent, std::vector<int> assigned);
+    int myPlayerClosestToOpponent(int opponent, const std::vector<int>& assigned);
 
     R2Action chooseBestThrowin();
     R2Action chooseBestCornerKick();
@@ -73,6 +74,8 @@ public:
     ~SimplePlayer(){}; 
 
     virtual R2Action step(const R2GameState gameState) override;
+    virtual bool isThreadSafe() override { return true; }  // it touches only its own members
+    virtual void reset() override;
 };
 
 std::unique_ptr<R2Simulator> buildSimplePlayerTwoTeamsSimulator(int nPlayers1, int nPlayers2,
@@ -13,22 +13,24 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <cstdio>
+#include <cstring>
 
 using namespace std;
 
 namespace r2s {
 
 //sets angle between 0 and 2 PI
-double fixAnglePositive(double angle){
-  double angle2=remainder(angle, 2*M_PI);
+R2Scalar fixAnglePositive(R2Scalar angle){
+  R2Scalar angle2=fremainder(angle, 2*M_PI);
   if(angle2< 0.0)
-    angle2= 2*M_PI + angle2;
+    angle2= R2Scalar(2*M_PI) + angle2;
   return angle2;
 }
 
 //sets angle between + and - PI
-double fixAngleTwoSides(double angle){
-  double angle2=remainder(angle, 2*M_PI);
+R2Scalar fixAngleTwoSides(R2Scalar angle){
+  R2Scalar angle2=fremainder(angle, 2*M_PI);
   //if(angle2< -M_PI) // it would never enter this condition because remainder returns the remaind to the number=quotient*divisor that is closer to dividend, so it will not be, in absolute terms, bigger than divisor/2  
   //  angle2= 2*M_PI + angle2;
   //if(angle2> M_PI)  // for the same reason it would never enter this condition as well. Different kind of "remainder" or "module" functions would need those conditions though.
@@ -53,11 +55,11 @@ void R2Simulator::limitPlayersCloseToPitch(){
 }
 
 void R2Simulator::setBallThrowInPosition(){
-  double borderY= (env.ball.pos.y > 0.0) ? pitch.y1 : pitch.y2;
-  double intersectionX=0.0;
+  R2Scalar borderY= (env.ball.pos.y > 0.0) ? pitch.y1 : pitch.y2;
+  R2Scalar intersectionX=0.0;
   Vec2 delta=env.ball.pos-oldEnv.ball.pos;
   if(fabs(delta.y)>R2BigEpsilon){
-    double m=delta.x/delta.y;
+    R2Scalar m=delta.x/delta.y;
     intersectionX=oldEnv.ball.pos.x + m*(borderY-oldEnv.ball.pos.y);
   }
   else{
@@ -84,11 +86,11 @@ bool R2Simulator::didBallIntersectGoalLine(const int team){
       return false;
   }
 
-  double goalX= ( (team && (!env.halftimePassed) ) || ( (!team) && env.halftimePassed) )? pitch.x1 : pitch.x2;
+  R2Scalar goalX= ( (team && (!env.halftimePassed) ) || ( (!team) && env.halftimePassed) )? pitch.x1 : pitch.x2;
   Vec2 delta=env.ball.pos-oldEnv.ball.pos;
   if(delta.x!=0.0){
-    double m=delta.y/delta.x;
-    double intersectionY=oldEnv.ball.pos.y + m*(goalX-oldEnv.ball.pos.x);
+    R2Scalar m=delta.y/delta.x;
+    R2Scalar intersectionY=oldEnv.ball.pos.y + m*(goalX-oldEnv.ball.pos.x);
     if((intersectionY > pitch.yGoal2) &&(intersectionY < pitch.yGoal1)){
       return true;
     }
@@ -102,12 +104,12 @@ bool R2Simulator::isGoalScored(int team){
   }
   // if it entered the goal passing through an external path, reposition the ball in an outside zone
   if(isBallInGoal(team)){
-    double goalX= ( (team && (!env.halftimePassed) ) || ( (!team) && env.halftimePassed) ) ? pitch.x1 : pitch.x2;
-    double epsilonOut= ( (team && (!env.halftimePassed) ) || ( (!team) && env.halftimePassed) ) ? R2Epsilon : -R2Epsilon;
+    R2Scalar goalX= ( (team && (!env.halftimePassed) ) || ( (!team) && env.halftimePassed) ) ? pitch.x1 : pitch.x2;
+    R2Scalar epsilonOut= ( (team && (!env.halftimePassed) ) || ( (!team) && env.halftimePassed) ) ? R2Epsilon : -R2Epsilon;
     Vec2 delta=env.ball.pos-oldEnv.ball.pos;
     if(delta.x!=0.0){
-      double m=delta.y/delta.x;
-      double intersectionY=oldEnv.ball.pos.y + m*(goalX-oldEnv.ball.pos.x);
+      R2Scalar m=delta.y/delta.x;
+      R2Scalar intersectionY=oldEnv.ball.pos.y + m*(goalX-oldEnv.ball.pos.x);
       env.ball.pos.x=goalX+epsilonOut;
       env.ball.pos.y=intersectionY;
     }
@@ -183,18 +185,18 @@ bool R2Simulator::isPlayerInsideOpponentAreaFullBody(const int player, const int
 }
 
 void R2Simulator::limitBallSpeed(){
-  double absSpeed=env.ball.absVelocity();
+  R2Scalar absSpeed=env.ball.absVelocity();
   if(absSpeed>sett.maxBallSpeed){
-    double ratio=sett.maxBallSpeed/absSpeed;
+    R2Scalar ratio=sett.maxBallSpeed/absSpeed;
     env.ball.velocity*=ratio;
   }
 }
 
 void R2Simulator::limitPlayerSpeed(R2PlayerInfo& p){
-  double absSpeed=p.absVelocity();
+  R2Scalar absSpeed=p.absVelocity();
   if(absSpeed>sett.maxPlayerSpeed)
   {
-    double ratio=sett.maxPlayerSpeed/absSpeed;
+    R2Scalar ratio=sett.maxPlayerSpeed/absSpeed;
     p.velocity*=ratio;
   }
 }
@@ -211,22 +213,23 @@ void R2Simulator::decayPlayerSpeed(R2PlayerInfo& p){
     return;
 
   //finding and fix 2D gymbal lock
-  double velAngle= atan2(p.velocity.y, p.velocity.x);
-  double velAngleBis=fixAnglePositive(velAngle);
-  double playerDir=p.direction;
-  double diff=playerDir-velAngleBis;
+  R2Scalar velAngle= fatan2(p.velocity.y, p.velocity.x);
+  R2Scalar velAngleBis=fixAnglePositive(velAngle);
+  R2Scalar playerDir=p.direction;
+  R2Scalar diff=playerDir-velAngleBis;
   if(diff>M_PI)
-    playerDir-=2*M_PI;
+    playerDir-=R2Scalar(2*M_PI);
   else if(diff<-M_PI)
-    velAngleBis-=2*M_PI;
+    velAngleBis-=R2Scalar(2*M_PI);
 
-  double len=p.velocity.len();
-  double newAngle= velAngleBis*(1.0 - sett.playerVelocityDirectionMix) + playerDir*sett.playerVelocityDirectionMix;
+  R2Scalar len=p.velocity.len();
+  R2Scalar newAngle= velAngleBis*(R2Scalar(1) - sett.playerVelocityDirectionMix) + playerDir*sett.playerVelocityDirectionMix;
   Vec2 newVelocity(newAngle);
   p.velocity=newVelocity*len*sett.playerVelocityDecay;
 }
 
 void R2Simulator::decaySpeed(){
+  R2S_PROFILE_PHASE(R2Phase::DecaySpeed);
   env.ball.velocity *= sett.ballVelocityDecay;
   
   for(auto& p : env.teams[0])
@@ -237,35 +240,37 @@ void R2Simulator::decaySpeed(){
 
 void R2Simulator::setBallCatchedPosition(){
     auto& goalkeeper=env.teams[env.ballCatchedTeam2][0];
-    double d=sett.playerRadius -sett.ballRadius -sett.afterCatchDistance;
-    env.ball.pos.x=goalkeeper.pos.x+cos(goalkeeper.direction)*d;
-    env.ball.pos.y=goalkeeper.pos.y+sin(goalkeeper.direction)*d;
+    R2Scalar d=sett.playerRadius -sett.ballRadius -sett.afterCatchDistance;
+    Vec2 front(goalkeeper.direction);
+    env.ball.pos.x=goalkeeper.pos.x+front.x*d;
+    env.ball.pos.y=goalkeeper.pos.y+front.y*d;
     env.ball.velocity=goalkeeper.velocity;
 }
 void R2Simulator::setBallReleasedPosition(){
     auto& goalkeeper=env.teams[env.ballCatchedTeam2][0];
-    double d=sett.playerRadius +sett.ballRadius +sett.afterCatchDistance;
-    env.ball.pos.x=goalkeeper.pos.x+cos(goalkeeper.direction)*d;
-    env.ball.pos.y=goalkeeper.pos.y+sin(goalkeeper.direction)*d;
+    R2Scalar d=sett.playerRadius +sett.ballRadius +sett.afterCatchDistance;
+    Vec2 front(goalkeeper.direction);
+    env.ball.pos.x=goalkeeper.pos.x+front.x*d;
+    env.ball.pos.y=goalkeeper.pos.y+front.y*d;
     env.ball.velocity=goalkeeper.velocity;
 }
 
 // team is the team to be put far from ball
-void R2Simulator::putPlayersFarFromBall(int team, double minDist){
+void R2Simulator::putPlayersFarFromBall(int team, R2Scalar minDist){
   for(auto& p: env.teams[team])
   {
     auto [dist, d]=p.dist(env.ball); 
     if(dist < minDist){
       if(dist<R2Epsilon) {
-        double angle=uniformDist(rng)*2*M_PI;
-        double sx=cos(angle)*minDist;
-        double sy=sin(angle)*minDist;
+        R2Scalar angle=randomUniform(R2RandomPurpose::FarFromBall, team, int(&p - env.teams[team].data()))*2*M_PI;
+        R2Scalar sx=fcos(angle)*minDist;
+        R2Scalar sy=fsin(angle)*minDist;
           p.pos.x-=sx;
           p.pos.y-=sy;
       }
       else {
-        double ratio=minDist/dist;
-        double diff=ratio-1.0;
+        R2Scalar ratio=minDist/dist;
+        R2Scalar diff=ratio-R2Scalar(1);
         if(diff>0.0){
           p.pos.x-=d.x*diff;
           p.pos.y-=d.y*diff;
@@ -288,20 +293,20 @@ Vec2 R2Simulator::avoidOtherPlayersPosition(Vec2 pos, int team, int player){
         auto other=env.teams[w][n];
         if(other.acted){
           Vec2 delta=other.pos-pos;
-          double dist=delta.len();
+          R2Scalar dist=delta.len();
           if(dist<R2Epsilon) {
             collisions=true;
-            double angle=uniformDist(rng)*2*M_PI;
-            double sx=cos(angle)*sett.playerRadius*2;
-            double sy=sin(angle)*sett.playerRadius*2;
+            R2Scalar angle=randomUniform(R2RandomPurpose::AvoidPlayers, team, player)*2*M_PI;
+            R2Scalar sx=fcos(angle)*sett.playerRadius*2;
+            R2Scalar sy=fsin(angle)*sett.playerRadius*2;
             pos.x+=sx;
             pos.y+=sy;
           }
           else {
-            double ratio=sett.playerRadius*2/dist;
+            R2Scalar ratio=sett.playerRadius*2/dist;
             if(ratio>1.0){
               collisions=true;
-              double toAdd= ratio-1.0;
+              R2Scalar toAdd= ratio-R2Scalar(1);
               pos.x+=delta.x*toAdd;
               pos.y+=delta.y*toAdd;
             }
@@ -344,29 +349,29 @@ void R2Simulator::actionMoveKickoff(const R2Action& action, int team, int player
   }
 
   //stay far from the center circle
-  double dueDistance=sett.centerRadius+sett.playerRadius;
+  R2Scalar dueDistance=sett.centerRadius+sett.playerRadius;
   if( (env.state==R2State::Kickoff1) && team ){
-      double dist=pos.len();
+      R2Scalar dist=pos.len();
       if(dist<=R2Epsilon){
         pos.x=dueDistance;
-        pos.y=uniformDist(rng);
+        pos.y=randomUniform(R2RandomPurpose::KickoffPosition, team, player);
       }
       else if (dist < dueDistance)
       {
-        double ratio=dueDistance/dist;
+        R2Scalar ratio=dueDistance/dist;
         pos.x*=ratio;
         pos.y*=ratio;
       }
   }
   else if( (env.state==R2State::Kickoff2) && (!team) ){
-      double dist=pos.len();
+      R2Scalar dist=pos.len();
       if(dist<=R2Epsilon){
         pos.x=-dueDistance;
-        pos.y=uniformDist(rng);
+        pos.y=randomUniform(R2RandomPurpose::KickoffPosition, team, player);
       }
       else if (dist < dueDistance)
       {
-        double ratio=dueDistance/dist;
+        R2Scalar ratio=dueDistance/dist;
         pos.x*=ratio;
         pos.y*=ratio;
       }
@@ -380,13 +385,13 @@ void R2Simulator::actionMoveKickoff(const R2Action& action, int team, int player
 void R2Simulator::actionMoveGoalkick(const R2Action& action, int team, int player){
   auto& p= env.teams[team][player];
   Vec2 pos(action.data[0],action.data[1]);
-  double dir=fixAnglePositive(action.data[2]);
+  R2Scalar dir=fixAnglePositive(action.data[2]);
 
   Vec2 displace=pos-p.pos;
   //player of the kicking team: taking note of the longest movement
   if( ( ((env.state==R2State::Goalkick1up)||(env.state==R2State::Goalkick1down)) && (!team) ) || 
       ( ((env.state==R2State::Goalkick2up)||(env.state==R2State::Goalkick2down)) && team ) ){
-    double movement=displace.len();
+    R2Scalar movement=displace.len();
     if(movement>env.startingTeamMaxRange)
       env.startingTeamMaxRange=movement;
   }
@@ -415,16 +420,16 @@ void R2Simulator::actionMoveGoalkick(const R2Action& action, int team, int playe
   p.direction=dir; 
 }
 
-void R2Simulator::actionMoveThrowinCorner(const R2Action& action, int team, int player, double distanceToBall){
+void R2Simulator::actionMoveThrowinCorner(const R2Action& action, int team, int player, R2Scalar distanceToBall){
   auto& p= env.teams[team][player];
   Vec2 pos(action.data[0],action.data[1]);
-  double dir=fixAnglePositive(action.data[2]);
+  R2Scalar dir=fixAnglePositive(action.data[2]);
 
   Vec2 displace=pos-p.pos;
   //player of the kicking team: taking note of the longest movement
   if( ( ((env.state==R2State::Throwin1)||(env.state==R2State::Corner1up)||(env.state==R2State::Corner1down)) && (!team) ) ||
       ( ((env.state==R2State::Throwin2)||(env.state==R2State::Corner2up)||(env.state==R2State::Corner2down)) && team ) ){
-    double movement=displace.len();
+    R2Scalar movement=displace.len();
     if(movement>env.startingTeamMaxRange)
       env.startingTeamMaxRange=movement;
   }
@@ -438,8 +443,8 @@ void R2Simulator::actionMoveThrowinCorner(const R2Action& action, int team, int
   // if not of kicker team stay away fom the ball
   if( ( ((env.state==R2State::Throwin1)||(env.state==R2State::Corner1up)||(env.state==R2State::Corner1down)) && team ) || 
       ( ((env.state==R2State::Throwin2)||(env.state==R2State::Corner2up)||(env.state==R2State::Corner2down)) && (!team) ) ){ 
-    double d=pos.dist(env.ball.pos);
-    while(d<distanceToBall){
+    R2Scalar d=pos.dist(env.ball.pos);
+    if(d<distanceToBall){   // a while() here never ended, d not being updated
       Vec2 line=pos-env.ball.pos;
       line.resize(distanceToBall);
       pos=env.ball.pos+line;
@@ -465,23 +470,24 @@ void R2Simulator::actionMoveCorner(const R2Action& action, int team, int player)
 void R2Simulator::actionDash(const R2Action& action, int team, int player){
   auto& p= env.teams[team][player];
   // limit power
-  double power=action.data[1];
-  double reverse=0.0;
+  R2Scalar power=action.data[1];
+  R2Scalar reverse=0.0;
   if(power < 0.0){
     power= -power;
     reverse=1.0;
   }
-  power+=sett.playerRandomNoise*(normalDist(rng)-0.5)*action.data[1];  //add random
+  power+=sett.playerRandomNoise*(randomNormal(R2RandomPurpose::DashPower, team, player)-0.5)*action.data[1];  //add random
   if(power <0.0)
     power=0.0;
 
   if(power >=MaxDashPower)
     power=MaxDashPower;
   
-  double angle=action.data[0] + reverse*M_PI + sett.playerDirectionNoise*(normalDist(rng)-0.5);
+  R2Scalar angle=action.data[0] + reverse*M_PI + sett.playerDirectionNoise*(randomNormal(R2RandomPurpose::DashDirection, team, player)-0.5);
 
-  p.velocity.x+=cos(angle)*power;
-  p.velocity.y+=sin(angle)*power;
+  Vec2 push(angle);
+  p.velocity.x+=push.x*power;
+  p.velocity.y+=push.y*power;
   p.direction=fixAnglePositive(angle);
 }
 
@@ -509,7 +515,8 @@ void R2Simulator::actionKick(const R2Action& action, int team, int player){
     // is ball in front of player?
     if(!catchedKicking)
       if(canKick && (!isAnyTeamKicking())){
-        double cosinusPlayerBall= (d.x*cos(p.direction) + d.y*sin(p.direction))/dist;
+        Vec2 front(p.direction);
+        R2Scalar cosinusPlayerBall= (d.x*front.x + d.y*front.y)/dist;
         if(cosinusPlayerBall < cosKickableAngle)
           canKick=false;
       }
@@ -520,7 +527,7 @@ void R2Simulator::actionKick(const R2Action& action, int team, int player){
         for(int w=0; w<=1; w++)
           for(int n=0; n< env.teams[w].size(); n++){
             auto pl=env.teams[w][n];
-            double d=(pl.pos-env.ball.pos).len();
+            R2Scalar d=(pl.pos-env.ball.pos).len();
             if(d<sett.playerRadius)  // well inside the player
               canKick=false;
           }
@@ -528,21 +535,21 @@ void R2Simulator::actionKick(const R2Action& action, int team, int player){
   
   
   // limit power
-  double reverse=0.0;
-  double power=action.data[1];
+  R2Scalar reverse=0.0;
+  R2Scalar power=action.data[1];
   if(power < 0.0){
     power= -power;
     reverse=1.0;
   }
-  power+=sett.playerRandomNoise*(normalDist(rng)-0.5)*action.data[1];  //add random
+  power+=sett.playerRandomNoise*(randomNormal(R2RandomPurpose::KickPower, team, player)-0.5)*action.data[1];  //add random
   if(power <0.0)
     power=0.0;
 
-  double angle=action.data[0] + reverse*M_PI;
-  double kickAngle=fixAnglePositive(angle);
+  R2Scalar angle=action.data[0] + reverse*M_PI;
+  R2Scalar kickAngle=fixAnglePositive(angle);
   if(! sett.simplified){
     if(canKick && (!isAnyTeamKicking())){
-      if( fabs( remainder( kickAngle-p.direction , 2*M_PI ) ) > sett.kickableDirectionAngle) // if angle between player direction and kick direction > kickableDirectionAngle or < -kickableDirectionAngle
+      if( fabs( fremainder( kickAngle-p.direction , 2*M_PI ) ) > sett.kickableDirectionAngle) // if angle between player direction and kick direction > kickableDirectionAngle or < -kickableDirectionAngle
         canKick=false;
     }
   }
@@ -550,7 +557,7 @@ void R2Simulator::actionKick(const R2Action& action, int team, int player){
 
   if(canKick && ballAlreadyKicked){
     if(! sett.simplified){
-      if(uniformDist(rng)>ContemporaryKickProbability)
+      if(randomUniform(R2RandomPurpose::ContemporaryKick, team, player)>ContemporaryKickProbability)
         canKick=false;
     }
     else{
@@ -558,7 +565,7 @@ void R2Simulator::actionKick(const R2Action& action, int team, int player){
     }
   }
   
-  kickAngle+=sett.playerDirectionNoise*(normalDist(rng)-0.5);
+  kickAngle+=sett.playerDirectionNoise*(randomNormal(R2RandomPurpose::KickDirection, team, player)-0.5);
   kickAngle=fixAnglePositive(kickAngle);
 
   p.direction=kickAngle;
@@ -568,12 +575,14 @@ void R2Simulator::actionKick(const R2Action& action, int team, int player){
   }
   else if(sett.simplified && canKick && (!isAnyTeamKicking()) ){ //if ball behind or too lateral, put it in front
     auto [dist, delta]=p.dist(env.ball); 
-    double cosinusPlayerBall= (delta.x*cos(p.direction) + delta.y*sin(p.direction))/dist;
+    Vec2 front(p.direction);
+    R2Scalar cosinusPlayerBall= (delta.x*front.x + delta.y*front.y)/dist;
     if(cosinusPlayerBall < 0.707){ // less than 45 degrees
-      double d=sett.playerRadius +sett.ballRadius +sett.afterCatchDistance;
+      R2Scalar d=sett.playerRadius +sett.ballRadius +sett.afterCatchDistance;
       //std::cout << "old ball position: x=" << env.ball.pos.x << " y=" << env.ball.pos.y << "\n";
-      env.ball.pos.x=p.pos.x+cos(kickAngle)*d;
-      env.ball.pos.y=p.pos.y+sin(kickAngle)*d;
+      Vec2 kick(kickAngle);
+      env.ball.pos.x=p.pos.x+kick.x*d;
+      env.ball.pos.y=p.pos.y+kick.y*d;
       //std::cout << "new ball position: x=" << env.ball.pos.x << " y=" << env.ball.pos.y << "\n";
       env.ball.velocity.x=0;
       env.ball.velocity.y=0;
@@ -593,6 +602,7 @@ void R2Simulator::actionKick(const R2Action& action, int team, int player){
 
     env.ball.velocity += kickDirection*power;
     ballAlreadyKicked=true;
+    events.kicks[team]++;
     
   }
 }
@@ -617,12 +627,13 @@ void R2Simulator::actionCatch(const R2Action& action, int team, int player){
     return;
 
   // is ball in front of player?
-  double cosinusPlayerBall= (d.x*cos(p.direction) + d.y*sin(p.direction))/dist;
+  Vec2 front(p.direction);
+  R2Scalar cosinusPlayerBall= (d.x*front.x + d.y*front.y)/dist;
   if(cosinusPlayerBall < cosCatchableAngle)  // angle > 90 or < -90 between player direction and ball direction
     return;
 
   // check catch probability
-  if(uniformDist(rng) <=sett.catchProbability)
+  if(randomUniform(R2RandomPurpose::Catch, team, player) <=sett.catchProbability)
   {
     env.ball.velocity.x=0.0;
     env.ball.velocity.y=0.0;
@@ -630,27 +641,22 @@ void R2Simulator::actionCatch(const R2Action& action, int team, int player){
     env.lastTouchedTeam2=team;
     env.ballCatchedTeam2=team;
     env.ballCatched=sett.catchHoldingTicks;
+    events.catches[team]++;
   }
 }
 
 // is a team prepare for kicking from stopped game ?
 bool R2Simulator::isAnyTeamPreparingKicking(){
-  if(notStarterStates.count(env.state))
-    return false;
-  return true;
+  return stateProperties(env.state).starter;
 }
 
 // is a team kicking from stopped game ?
 bool R2Simulator::isAnyTeamKicking(){
-  if((env.state==R2State::Play) && (notStarterStates.count(oldEnv.state)==0))
-    return true;
-  return false;
+  return (env.state==R2State::Play) && stateProperties(oldEnv.state).starter;
 }
 
 bool R2Simulator::isTeam2Kicking(R2State theState){
-  if(team2StarterStates.count(theState))
-    return true;
-  return false;
+  return stateProperties(theState).team2;
 }
 
 void R2Simulator::resetPlayersActed(){
@@ -661,16 +667,239 @@ void R2Simulator::resetPlayersActed(){
     }
 }
 
+const R2GameState& R2Simulator::refreshAgentsState(){
+  agentsState.sett=sett;
+  agentsState.env=env;
+  agentsState.pitch=pitch;
+  return agentsState;
+}
+
+// index of the next number of a counter-based random stream, in the current tick
+uint32_t R2Simulator::nextRandomIndex(R2RandomPurpose purpose, int team, int player){
+  int players=shuffledPlayers.size();
+  int slot= (team<0) ? players : team*int(env.teams[0].size())+player;
+  return randomDraws[int(purpose)*(players+1) + slot]++;
+}
+
+double R2Simulator::randomUniform(R2RandomPurpose purpose, int team, int player){
+  if(!counterRandom)
+    return uniformDist(rng);
+  uint32_t stream= (uint32_t(purpose)<<16) | uint32_t((team<0) ? 0xFFFF : team*int(env.teams[0].size())+player);
+  return counterRng.uniform(uint32_t(env.tick), stream, nextRandomIndex(purpose, team, player));
+}
+
+double R2Simulator::randomNormal(R2RandomPurpose purpose, int team, int player){
+  if(!counterRandom)
+    return normalDist(rng);
+  uint32_t stream= (uint32_t(purpose)<<16) | uint32_t((team<0) ? 0xFFFF : team*int(env.teams[0].size())+player);
+  return counterRng.normal(uint32_t(env.tick), stream, nextRandomIndex(purpose, team, player));
+}
+
+// the order in which players act when it is not a kick
+void R2Simulator::shufflePlayers(){
+  if(!counterRandom){
+    shuffle(begin(shuffledPlayers), end(shuffledPlayers), rng);
+    return;
+  }
+  // Fisher-Yates, that std::shuffle may not use
+  uint32_t stream= uint32_t(R2RandomPurpose::Shuffle)<<16;
+  for(int i=int(shuffledPlayers.size())-1; i>0; i--){
+    int j=int(counterRng.uniformInt(uint32_t(i+1), uint32_t(env.tick), stream, nextRandomIndex(R2RandomPurpose::Shuffle, -1, 0)));
+    std::swap(shuffledPlayers[i], shuffledPlayers[j]);
+  }
+}
+
+void R2Simulator::captureState(int team, int player, const R2GameState& gameState){
+  if(capturedStates && ((env.tick % captureEveryTicks) == 0))
+    capturedStates->push_back(R2StateSample(team, player, gameState));
+}
+
+// calls the agent step() measuring its latency, and enforcing the step time budget if any
+R2Action R2Simulator::callAgent(int team, int player, const R2GameState& gameState){
+  captureState(team, player, gameState);
+  if(!isTimingAgents())
+    return teams[team][player]->step(gameState);
+
+  auto start=std::chrono::steady_clock::now();
+  R2Action action=teams[team][player]->step(gameState);
+  uint64_t ns=uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count());
+  return checkAgentLatency(team, player, action, ns);
+}
+
+// records the latency of an agent step() if tracked, returning NoOp instead of its action if over the step time budget
+R2Action R2Simulator::checkAgentLatency(int team, int player, const R2Action& action, uint64_t ns){
+  if(agentLatencyTracking){
+    agentLatency[team][player].latency.add(ns);
+    teamLatency[team].latency.add(ns);
+  }
+  if(stepTimeBudgetNs && (ns > stepTimeBudgetNs)){
+    agentLatency[team][player].overruns++;
+    teamLatency[team].overruns++;
+    return R2Action();
+  }
+  return action;
+}
+
+// the action given through stepN(), if any, otherwise the one chosen by the player agent
+R2Action R2Simulator::askPlayerAction(int team, int player, const R2GameState& gameState){
+  R2S_PROFILE_PHASE(R2Phase::PlayersAgents);
+  int index= team*teams[0].size() + player;
+  if(givenActions[index])
+    return givenActionsValues[index];
+  if(observationLatency)
+    return pipelinedPlayerAction(team, player, index);
+  if(concurrentDecided[index]){  // already chosen by askPlayersActionsConcurrently(), the rest is done here to keep the serial order
+    concurrentDecided[index]=0;
+    captureState(team, player, gameState);
+    if(!isTimingAgents())
+      return concurrentActions[index];
+    return checkAgentLatency(team, player, concurrentActions[index], concurrentNs[index]);
+  }
+  return callAgent(team, player, gameState);
+}
+
+// runs concurrently the step() of the agents that will receive the same game state, before they are asked for their action
+void R2Simulator::askPlayersActionsConcurrently(const R2GameState& gameState){
+  R2S_PROFILE_PHASE(R2Phase::PlayersAgents);
+  int size0=teams[0].size();
+  for(int index=0; index<int(concurrentDecided.size()); index++){
+    int team= int(index>=size0);
+    int player= index - team*size0;
+    concurrentDecided[index]= (!givenActions[index]) && teams[team][player]->isThreadSafe();
+  }
+  bool timing=isTimingAgents();
+  agentsPool->parallelFor(int(concurrentDecided.size()), [&](int index){
+    if(!concurrentDecided[index])
+      return;
+    int team= int(index>=size0);
+    int player= index - team*size0;
+    if(!timing){
+      concurrentActions[index]=teams[team][player]->step(gameState);
+      return;
+    }
+    auto start=std::chrono::steady_clock::now();
+    concurrentActions[index]=teams[team][player]->step(gameState);
+    concurrentNs[index]=uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count());
+  });
+}
+
+void R2Simulator::setAgentThreads(int threads){
+  if(pipelineWorker)  // it may be using the pool
+    pipelineWorker->drain();
+  if(threads>1)
+    agentsPool=std::make_unique<R2ThreadPool>(threads);
+  else
+    agentsPool.reset();
+}
+
+R2Action R2Simulator::askPlayerAction(int team, int player){
+  R2S_PROFILE_PHASE(R2Phase::PlayersAgents);
+  int index= team*teams[0].size() + player;
+  if(givenActions[index])
+    return givenActionsValues[index];
+  if(observationLatency)
+    return pipelinedPlayerAction(team, player, index);
+  return callAgent(team, player, refreshAgentsState());
+}
+
+void R2Simulator::setObservationLatency(int ticks){
+  observationLatency=std::max(ticks, 0);
+  startPipeline();
+}
+
+// (re)starts the pipeline from scratch, forgetting the observations made so far
+void R2Simulator::startPipeline(){
+  pipelineWorker.reset();  // it waits for the decisions still running
+  pipelineTicks=0;
+  pipelineCurrent=-1;
+  if(observationLatency==0){
+    pipelineSlots=std::vector<R2PipelineSlot>();
+    return;
+  }
+  pipelineSlots.assign(observationLatency+1, R2PipelineSlot(getGameState(), shuffledPlayers.size()));
+  int size0=teams[0].size();
+  pipelinedAgents.assign(shuffledPlayers.size(), 0);
+  for(int index=0; index<int(pipelinedAgents.size()); index++){
+    int team= int(index>=size0);
+    pipelinedAgents[index]= teams[team][index - team*size0]->isThreadSafe();
+  }
+  pipelineWorker=std::make_unique<R2AsyncWorker>([this](uint64_t ticket){ decidePipelined(ticket); });
+}
+
+// submits the current game state to the agents, and waits for the decisions taken on the one observed observationLatency ticks ago
+void R2Simulator::advancePipeline(){
+  R2S_PROFILE_PHASE(R2Phase::PlayersAgents);
+  int slots=pipelineSlots.size();
+  R2GameState& observation=pipelineSlots[pipelineTicks % slots].state;  // its previous decisions have been used in the previous tick
+  observation.sett=sett;
+  observation.env=env;
+  observation.pitch=pitch;
+  pipelineWorker->submit();
+  pipelineTicks++;
+
+  if(pipelineTicks <= uint64_t(observationLatency)){
+    pipelineCurrent=-1;
+    return;
+  }
+  uint64_t ticket=pipelineTicks-1-observationLatency;
+  pipelineWorker->wait(ticket);
+  pipelineCurrent=int(ticket % slots);
+}
+
+// runs on the pipeline worker: the thread safe agents decide on an observation
+void R2Simulator::decidePipelined(uint64_t ticket){
+  R2PipelineSlot& slot=pipelineSlots[ticket % pipelineSlots.size()];
+  bool timing=isTimingAgents();
+  auto decide=[this, &slot, timing](int index){
+    if(!pipelinedAgents[index])  // the others may be running step() on the simulator thread right now
+      return;
+    int size0=teams[0].size();
+    int team= int(index>=size0);
+    int player= index - team*size0;
+    if(!timing){
+      slot.actions[index]=teams[team][player]->step(slot.state);
+      return;
+    }
+    auto start=std::chrono::steady_clock::now();
+    slot.actions[index]=teams[team][player]->step(slot.state);
+    slot.ns[index]=uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count());
+  };
+  int players=slot.actions.size();
+  if(agentsPool){
+    agentsPool->parallelFor(players, decide);
+  }
+  else{
+    for(int index=0; index<players; index++)
+      decide(index);
+  }
+}
+
+// the action chosen on the delayed observation
+R2Action R2Simulator::pipelinedPlayerAction(int team, int player, int index){
+  if(pipelineCurrent<0)
+    return R2Action();
+  R2PipelineSlot& slot=pipelineSlots[pipelineCurrent];
+  if(!pipelinedAgents[index])
+    return callAgent(team, player, slot.state);
+  captureState(team, player, slot.state);
+  if(!isTimingAgents())
+    return slot.actions[index];
+  return checkAgentLatency(team, player, slot.actions[index], slot.ns[index]);
+}
+
 void R2Simulator::playersAct(){
+  R2S_PROFILE_PHASE(R2Phase::PlayersAct);
+  if(observationLatency)
+    advancePipeline();
   if(isAnyTeamPreparingKicking() ){ // preparing kicking: the kicking team acts first, with the closest player acting first.
     int kickingTeam= int(isTeam2Kicking(env.state));
     int sizeKickingTeam=teams[kickingTeam].size();
     // let's find the closest to the ball
     int closest=0;
     if(sizeKickingTeam){
-      double minDist=env.teams[kickingTeam][0].pos.dist(env.ball.pos);
+      R2Scalar minDist=env.teams[kickingTeam][0].pos.dist(env.ball.pos);
       for(int n=1; n< env.teams[kickingTeam].size(); n++){
-        double distance=env.teams[kickingTeam][n].pos.dist(env.ball.pos);
+        R2Scalar distance=env.teams[kickingTeam][n].pos.dist(env.ball.pos);
         if(distance < minDist){
           minDist=distance;
           closest=n;
@@ -678,14 +907,14 @@ void R2Simulator::playersAct(){
       }
 
       //let's have the closest player acting first
-      R2Action action = teams[kickingTeam][closest]->step( getGameState() ); 
+      R2Action action = askPlayerAction(kickingTeam, closest); 
       env.teams[kickingTeam][closest].acted=true;
       processStep(action, kickingTeam, closest);
 
       //then all of his own team except him
       for(int n=0; n< sizeKickingTeam; n++){
         if(n!=closest){
-          action = teams[kickingTeam][n]->step( getGameState() ); // updated game state for each player
+          action = askPlayerAction(kickingTeam, n); // updated game state for each player
           env.teams[kickingTeam][n].acted=true;
           processStep(action, kickingTeam, n);
         }
@@ -695,7 +924,7 @@ void R2Simulator::playersAct(){
     //then all other team
     int team= 1-kickingTeam;
     for(int n=0; n< env.teams[team].size(); n++){
-      R2Action action = teams[team][n]->step( getGameState() ); // updated game state for each player
+      R2Action action = askPlayerAction(team, n); // updated game state for each player
       env.teams[team][n].acted=true;
       processStep(action, team, n);
     }
@@ -706,9 +935,9 @@ void R2Simulator::playersAct(){
     // let's find the closest to the ball
     int closest=0;
     if(teams[kickingTeam].size()){
-      double minDist=env.teams[kickingTeam][0].pos.dist(env.ball.pos);
+      R2Scalar minDist=env.teams[kickingTeam][0].pos.dist(env.ball.pos);
       for(int n=1; n< env.teams[kickingTeam].size(); n++){
-        double distance=env.teams[kickingTeam][n].pos.dist(env.ball.pos);
+        R2Scalar distance=env.teams[kickingTeam][n].pos.dist(env.ball.pos);
         if(distance < minDist){
           minDist=distance;
           closest=n;
@@ -716,13 +945,13 @@ void R2Simulator::playersAct(){
       }
 
       //let's have the closest player of the kicking team acting first
-      R2Action action = teams[kickingTeam][closest]->step( getGameState() );
+      R2Action action = askPlayerAction(kickingTeam, closest);
       env.teams[kickingTeam][closest].acted=true;
       processStep(action, kickingTeam, closest);
     }
 
     //now all the rest, shuffled
-    shuffle(begin(shuffledPlayers), end(shuffledPlayers), rng);
+    shufflePlayers();
     for(int i: shuffledPlayers){
       int whichTeam=0;
       
@@ -731,15 +960,17 @@ void R2Simulator::playersAct(){
         i=index_team2;
       }
       if((i!=closest)||(whichTeam !=kickingTeam)){
-        R2Action action = teams[whichTeam][i]->step( getGameState() ); // updated game state for each player
+        R2Action action = askPlayerAction(whichTeam, i); // updated game state for each player
         env.teams[whichTeam][i].acted=true;
         processStep(action, whichTeam, i);
       }
     }
   }
   else{  // if not right after a stop-game begin, the player order is shuffled
-    shuffle(begin(shuffledPlayers), end(shuffledPlayers), rng);
-    auto gameState = getGameState();
+    shufflePlayers();
+    const R2GameState& gameState = refreshAgentsState();
+    if(agentsPool && !observationLatency)
+      askPlayersActionsConcurrently(gameState);
     for(int i: shuffledPlayers){
       int whichTeam = 0;
       
@@ -747,7 +978,7 @@ void R2Simulator::playersAct(){
           whichTeam = 1;
         i=index_team2;
       }
-      R2Action action = teams[whichTeam][i]->step( gameState ); // same game state for each player
+      R2Action action = askPlayerAction(whichTeam, i, gameState); // same game state for each player
       env.teams[whichTeam][i].acted=true;
       processStep(action, whichTeam, i);
     }
@@ -755,8 +986,15 @@ void R2Simulator::playersAct(){
 }
 
 void R2Simulator::step(){
-  history.envs[env.tick]=env;
+  R2S_PROFILE_TICK();
+  {
+    R2S_PROFILE_PHASE(R2Phase::History);
+    if(historyEnabled)
+      history.envs[env.tick]=env;
+  }
   processedActions=0;
+  if(counterRandom)
+    std::fill(randomDraws.begin(), randomDraws.end(), 0);
 
   resetPlayersActed();
   preState();
@@ -766,8 +1004,17 @@ void R2Simulator::step(){
   checkState();
   decaySpeed();
   env.tick += 1;
+  if(stateHashing)
+    recordStateHash();
 };
 
+void R2Simulator::recordStateHash(){
+  uint64_t h=hashEnvironment(env);
+  if((env.tick>=0) && (env.tick<int(stateHashes.size())))
+    stateHashes[env.tick]=h;
+  stateDigest=(stateDigest ^ h)*0x100000001b3ULL + uint64_t(env.tick);
+}
+
 bool R2Simulator::checkBallOut(){
 
   auto doBallLeftUp=[&](){
@@ -856,11 +1103,11 @@ bool R2Simulator::checkBallOut(){
     }
     return false;
   }
-  double ratio=d.x/d.y;
+  R2Scalar ratio=d.x/d.y;
 
   if(isBallOutUp()){
-    double du=pitch.y1-oldEnv.ball.pos.y;
-    double hx=ratio*du+oldEnv.ball.pos.x;
+    R2Scalar du=pitch.y1-oldEnv.ball.pos.y;
+    R2Scalar hx=ratio*du+oldEnv.ball.pos.x;
 
     auto doBallUp=[&](){
       if(env.lastTouchedTeam2)
@@ -891,8 +1138,8 @@ bool R2Simulator::checkBallOut(){
     return true;
   }
   else if(isBallOutDown()){
-    double du=pitch.y2-oldEnv.ball.pos.y;
-    double hx=ratio*du+oldEnv.ball.pos.x;
+    R2Scalar du=pitch.y2-oldEnv.ball.pos.y;
+    R2Scalar hx=ratio*du+oldEnv.ball.pos.x;
 
     auto doBallDown=[&](){
       if(env.lastTouchedTeam2)
@@ -958,22 +1205,23 @@ bool R2Simulator::checkBallOut(){
 // results:
 // delta= b^2 - 4*a*c  // if <0 no intersection, if ==0 one tangent point, if >0 two intersections
 // t= (b +- sqrt(delta)) / (2*a)
-std::tuple<int, double, double> intersectionSegmentCircle(Vec2 s1, Vec2 s2, Vec2 c1, double r){
+std::tuple<int, R2Scalar, R2Scalar> intersectionSegmentCircle(Vec2 s1, Vec2 s2, Vec2 c1, R2Scalar r){
   Vec2 d= s1 - s2;
   Vec2 l= s1 - c1;
-  double a= d.x*d.x - d.y*d.y;
-  double b= 2.0*d.x*l.x + 2*d.y*l.y;
-  double c= l.x*l.x + l.y*l.y - r*r;
-  double delta= b*b - 4.0*a*c;
+  R2Scalar a= d.x*d.x - d.y*d.y;
+  R2Scalar two=2.0, four=4.0;   // so that with float the operations are not promoted to double, like in impact_kernel.h
+  R2Scalar b= two*d.x*l.x + two*d.y*l.y;
+  R2Scalar c= l.x*l.x + l.y*l.y - r*r;
+  R2Scalar delta= b*b - four*a*c;
   if(delta < 0.0){
-    return std::tuple<int, double, double>  { 0, 0.0, 0.0 };
+    return std::tuple<int, R2Scalar, R2Scalar>  { 0, 0.0, 0.0 };
   }
   else if(delta == 0.0){
-    return std::tuple<int, double, double>  { 1, b/(2.0*a), 0.0 };
+    return std::tuple<int, R2Scalar, R2Scalar>  { 1, b/(two*a), 0.0 };
   }
   else{
-    double deltaRoot= sqrt(delta);
-    return std::tuple<int, double, double>  { 2, (b-deltaRoot)/(2.0*a), (b+deltaRoot)/(2.0*a) };
+    R2Scalar deltaRoot= std::sqrt(delta);
+    return std::tuple<int, R2Scalar, R2Scalar>  { 2, (b-deltaRoot)/(two*a), (b+deltaRoot)/(two*a) };
   }
 }
 
@@ -1001,54 +1249,54 @@ std::tuple<int, double, double> intersectionSegmentCircle(Vec2 s1, Vec2 s2, Vec2
 // returns:
 // bool: if intersection happened
 // double: t of intersection
-std::tuple<bool, double> R2Simulator::findObjectsCollision(R2ObjectInfo& obj1, R2ObjectInfo&obj2, double radius, double partialT)
+std::tuple<bool, R2Scalar> R2Simulator::findObjectsCollision(R2ObjectInfo& obj1, R2ObjectInfo&obj2, R2Scalar radius, R2Scalar partialT)
 {
-  Vec2 s2= obj1.pos + (obj1.velocity - obj2.velocity)*(1.0 - partialT);
+  Vec2 s2= obj1.pos + (obj1.velocity - obj2.velocity)*(R2Scalar(1) - partialT);
   auto [n, t1, t2]=intersectionSegmentCircle(obj1.pos, s2, obj2.pos, radius);
   if(n==2){ // if tangent, no collision really happened
-    double t= (t1>=0.0) ? t1 : t2;  // we want the first intersection, unless it is less than 0.0 (that means there is not an actual intersection) in which case we check the second one(that is always greater than the first)
+    R2Scalar t= (t1>=0.0) ? t1 : t2;  // we want the first intersection, unless it is less than 0.0 (that means there is not an actual intersection) in which case we check the second one(that is always greater than the first)
     if( (t>=R2Epsilon) && (t<=1.0) )
-      return std::tuple<bool, double> {true, t} ;
+      return std::tuple<bool, R2Scalar> {true, t} ;
   }
-  return std::tuple<bool, double> {false, 0.0} ;
+  return std::tuple<bool, R2Scalar> {false, 0.0} ;
 }
 
 // returns:
 // bool: if intersection happened
 // double: t of intersection
-std::tuple<bool, double> R2Simulator::findBallPlayerCollision(int team, int player, double partialT)
+std::tuple<bool, R2Scalar> R2Simulator::findBallPlayerCollision(int team, int player, R2Scalar partialT)
 {
   return findObjectsCollision(env.ball, env.teams[team][player], sett.playerRadius+sett.ballRadius, partialT);
 }
 
-std::tuple<bool, double> R2Simulator::findPlayerPlayerCollision(int team1, int player1, int team2, int player2, double partialT){
+std::tuple<bool, R2Scalar> R2Simulator::findPlayerPlayerCollision(int team1, int player1, int team2, int player2, R2Scalar partialT){
     return findObjectsCollision(env.teams[team1][player1], env.teams[team2][player2], sett.playerRadius+sett.playerRadius, partialT);
 }
 
-std::tuple<bool, double> R2Simulator::findPoleObjectCollision(R2ObjectInfo& obj1, Vec2 pole, double radius, double partialT)
+std::tuple<bool, R2Scalar> R2Simulator::findPoleObjectCollision(R2ObjectInfo& obj1, Vec2 pole, R2Scalar radius, R2Scalar partialT)
 {
-  Vec2 s2= obj1.pos + obj1.velocity*(1.0 - partialT);
+  Vec2 s2= obj1.pos + obj1.velocity*(R2Scalar(1) - partialT);
   auto [n, t1, t2]=intersectionSegmentCircle(obj1.pos, s2, pole, radius);
   if(n==2){ // if tangent, no collision really happened
-    double t= (t1>=0.0) ? t1 : t2;  // we want the first intersection, unless it is less than 0.0 (that means there is not an actual intersection) in which case we check the second one(that is always greater than the first)
+    R2Scalar t= (t1>=0.0) ? t1 : t2;  // we want the first intersection, unless it is less than 0.0 (that means there is not an actual intersection) in which case we check the second one(that is always greater than the first)
     if( (t>=R2Epsilon) && (t<=1.0) )
-      return std::tuple<bool, double> {true, t} ;
+      return std::tuple<bool, R2Scalar> {true, t} ;
   }
-  return std::tuple<bool, double> {false, 0.0} ;
+  return std::tuple<bool, R2Scalar> {false, 0.0} ;
 }
 
 // returns:
 // bool: if intersection happened
 // double: t of intersection
-std::tuple<bool, double> R2Simulator::findPolePlayerCollision(int team, int player, Vec2 pole, double partialT){
+std::tuple<bool, R2Scalar> R2Simulator::findPolePlayerCollision(int team, int player, Vec2 pole, R2Scalar partialT){
   return findPoleObjectCollision(env.teams[team][player], pole, sett.playerRadius+sett.poleRadius, partialT);
 }
 
-std::tuple<bool, double> R2Simulator::findPoleBallCollision(Vec2 pole, double partialT){
+std::tuple<bool, R2Scalar> R2Simulator::findPoleBallCollision(Vec2 pole, R2Scalar partialT){
   return findPoleObjectCollision(env.ball, pole, sett.ballRadius+sett.poleRadius, partialT);
 }
 
-R2PoleBallCollision R2Simulator::findFirstPoleBallCollision(double partialT){
+R2PoleBallCollision R2Simulator::findFirstPoleBallCollision(R2Scalar partialT){
   R2PoleBallCollision collision(false, 1.1, 0);
   for(int i=0; i<4; i++){
     auto[found, t]= findPoleBallCollision(pitch.poles[i], partialT);
@@ -1062,14 +1310,22 @@ R2PoleBallCollision R2Simulator::findFirstPoleBallCollision(double partialT){
   return collision;
 }
 
-std::vector<R2PolePlayerCollision> R2Simulator::findFirstPolePlayersCollisions(double partialT){
-  std::vector<R2PolePlayerCollision> collisions;
-  double earlierT=1.1;
+// each player against the four poles at once, with the time of impact kernel. The earliest collisions replace the content of collisions.
+void R2Simulator::findFirstPolePlayersCollisions(R2Scalar partialT, std::vector<R2PolePlayerCollision>& collisions){
+  collisions.clear();
+  R2Scalar earlierT=1.1;
+  impactPoles.resize(4);
+  for(int i=0; i<4; i++)
+    impactPoles.set(i, pitch.poles[i], Vec2());
+  impactScratch[0].reserve(4);
+  R2Scalar* times=impactScratch[0].times.data();
   for(int w=0; w<=1; w++)
     for(int n=0; n< env.teams[w].size(); n++){
+      R2ObjectInfo& player=env.teams[w][n];
+      impactTimes(impactPoles, 0, 4, player.pos, player.velocity, sett.playerRadius+sett.poleRadius, partialT, R2Epsilon, times);
       for(int i=0; i<4; i++){
-        auto[found, t]= findPolePlayerCollision(w, n, pitch.poles[i], partialT);
-        if(found){ 
+        R2Scalar t=times[i];
+        if(t<=1.0){ 
           if(t<earlierT){
             collisions.clear();
           }
@@ -1082,68 +1338,367 @@ std::vector<R2PolePlayerCollision> R2Simulator::findFirstPolePlayersCollisions(d
         }
       }
     }
-  return collisions;
 }
 
-std::vector<R2BallPlayerCollision> R2Simulator::findFirstBallPlayersCollisions(double partialT, std::vector<bool>& ballPlayerBlacklist){
-  std::vector<R2BallPlayerCollision>  collisions;
-  double earlierT=1.1;
+// copies positions and velocities of the players in impactPlayers, and makes room for the times of impact of each chunk
+void R2Simulator::packImpactPlayers(int chunks){
   int t1size=env.teams[0].size();
-  for(int w=0; w<=1; w++)
-    for(int n=0; n< env.teams[w].size(); n++){
-      if(ballPlayerBlacklist[t1size*w+n])
+  int players=shuffledPlayers.size();
+  impactPlayers.resize(players);
+  for(int i=0; i<players; i++){
+    int w= int(i>=t1size);
+    R2ObjectInfo& player=env.teams[w][i - w*t1size];
+    impactPlayers.set(i, player.pos, player.velocity);
+  }
+  if(int(impactScratch.size()) < chunks)
+    impactScratch.resize(chunks);
+  for(int k=0; k<chunks; k++)
+    impactScratch[k].reserve(players);
+}
+
+// the earliest collisions of the ball with the players from first to last-1 (the second team following the first one),
+// added to collisions if not later than earlierT, that is updated. The players must have been packed by packImpactPlayers().
+void R2Simulator::scanBallPlayersCollisions(int first, int last, R2Scalar partialT, const std::vector<bool>& ballPlayerBlacklist, std::vector<R2BallPlayerCollision>& collisions, R2Scalar& earlierT, R2ImpactScratch& scratch){
+  int t1size=env.teams[0].size();
+  R2Scalar* times=scratch.times.data();
+  R2Scalar t=impactTimes(impactPlayers, first, last, env.ball.pos, env.ball.velocity, sett.playerRadius+sett.ballRadius, partialT, R2Epsilon, times);
+  if(t>1.0)
+    return;
+  bool excluded=false;
+  for(int i=first; i<last; i++)
+    if(ballPlayerBlacklist[i] && (times[i]<=1.0)){
+      times[i]=R2NoImpact;
+      excluded=true;
+    }
+  if(excluded){
+    t=earliestImpact(times, first, last);
+    if(t>1.0)
+      return;
+  }
+  if(t<earlierT){
+    collisions.clear();
+  }
+  if(t<=earlierT){
+    earlierT=t;
+    impactTies(times, first, last, t, scratch.ties.data());
+    forEachTie(scratch.ties.data(), last-first, [&](int j){
+      int w= int(first+j>=t1size);
+      int n= first + j - w*t1size;
+      R2BallPlayerCollision collision(t, n, w);
+      collisions.push_back(collision);
+    });
+  }
+}
+
+// when searched in parallel each chunk of players keeps its earliest collisions, then the chunks holding the overall earliest time
+// are concatenated in order: the same list that the serial scan returns
+void R2Simulator::findFirstBallPlayersCollisions(R2Scalar partialT, std::vector<bool>& ballPlayerBlacklist, std::vector<R2BallPlayerCollision>& collisions){
+  collisions.clear();
+  R2Scalar earlierT=1.1;
+  int players=shuffledPlayers.size();
+  if(!isParallelCollisionsSearch()){
+    packImpactPlayers(1);
+    scanBallPlayersCollisions(0, players, partialT, ballPlayerBlacklist, collisions, earlierT, impactScratch[0]);
+    return;
+  }
+
+  int chunks=collisionsPool->size()*ParallelCollisionsChunksPerThread;
+  packImpactPlayers(chunks);
+  collisionsChunkT.assign(chunks, 1.1);
+  if(int(ballPlayerChunkColls.size()) < chunks)
+    ballPlayerChunkColls.resize(chunks);
+  collisionsPool->parallelFor(chunks, [this, chunks, players, partialT, &ballPlayerBlacklist](int k){
+    ballPlayerChunkColls[k].clear();
+    scanBallPlayersCollisions(players*k/chunks, players*(k+1)/chunks, partialT, ballPlayerBlacklist, ballPlayerChunkColls[k], collisionsChunkT[k], impactScratch[k]);
+  });
+  for(int k=0; k<chunks; k++)
+    earlierT=std::min(earlierT, collisionsChunkT[k]);
+  for(int k=0; k<chunks; k++)
+    if(collisionsChunkT[k]==earlierT)
+      collisions.insert(collisions.end(), ballPlayerChunkColls[k].begin(), ballPlayerChunkColls[k].end());
+}
+
+// rows of the player-player pairs, in the order of the serial search: first team with first team, first team with second team,
+// second team with second team; in each of them a row holds the pairs of a player with the following ones (or all the opponents)
+int R2Simulator::playerPlayersRowPairs(int row){
+  int l0=env.teams[0].size();
+  int l1=env.teams[1].size();
+  if(row<l0)
+    return l0-row-1;
+  if(row<2*l0)
+    return l1;
+  return l1-(row-2*l0)-1;
+}
+
+// the earliest collisions among the player-player pairs of the rows from firstRow to lastRow-1 (see playerPlayersRowPairs()),
+// added to collisions if not later than earlierT, that is updated. The players must have been packed by packImpactPlayers().
+// If awake is given, the rows of the other players are skipped.
+void R2Simulator::scanPlayerPlayersCollisions(int firstRow, int lastRow, R2Scalar partialT, const std::vector<int>& playerPlayerCollisions, std::vector<R2PlayerPlayerCollision>& collisions, R2Scalar& earlierT, R2ImpactScratch& scratch, const std::vector<char>* awake){
+  int t1size=env.teams[0].size();
+  R2Scalar* times=scratch.times.data();
+  R2Scalar radius=sett.playerRadius+sett.playerRadius;
+  for(int row=firstRow; row<lastRow; row++){
+    int block= (row<t1size) ? 0 : ( (row<2*t1size) ? 1 : 2 );
+    int w1= int(block==2);
+    int w2= int(block!=0);  // do not check twice the collision betwenn the two teams
+    int n1= row - ( (block==2) ? 2*t1size : block*t1size );
+    int l2= env.teams[w2].size();
+    int start2 = (w1 == w2) ? (n1+1) : 0 ;
+    if((start2>=l2) || (awake && !(*awake)[w1*t1size+n1]))
+      continue;
+    int first=w2*t1size+start2, last=w2*t1size+l2;   // the other players of the row, as indexes of impactPlayers
+    R2ObjectInfo& player=env.teams[w1][n1];
+    R2Scalar t=impactTimes(impactPlayers, first, last, player.pos, player.velocity, radius, partialT, R2Epsilon, times);
+    if(t>1.0)
+      continue;
+    int prior=playerPlayerCollisions[w1*t1size+n1];
+    if((prior>=first) && (prior<last) && (times[prior]<=1.0)){ // only if not just prior collision
+      times[prior]=R2NoImpact;
+      t=earliestImpact(times, first, last);
+      if(t>1.0)
         continue;
-      auto[found, t]= findBallPlayerCollision(w, n, partialT);
-      if(found){ 
-        if(t<earlierT){
-          collisions.clear();
-        }
-        if(t<=earlierT){
-          earlierT=t;
-          R2BallPlayerCollision collision(t, n, w);
-          collisions.push_back(collision);
+    }
+    if(t<earlierT){
+      collisions.clear();
+    }
+    if(t<=earlierT){
+      earlierT=t;
+      impactTies(times, first, last, t, scratch.ties.data());
+      forEachTie(scratch.ties.data(), last-first, [&](int j){
+        R2PlayerPlayerCollision collision(t, n1, w1, start2+j, w2);
+        collisions.push_back(collision);
+      });
+    }
+  }
+}
+
+void R2Simulator::findFirstPlayerPlayersCollisions(R2Scalar partialT, std::vector<int>& playerPlayerCollisions, std::vector<R2PlayerPlayerCollision>& collisions, const std::vector<char>* awake){
+  collisions.clear();
+  R2Scalar earlierT=1.1;
+  int rows=env.teams[0].size()*2 + env.teams[1].size();
+  if(!isParallelCollisionsSearch()){
+    packImpactPlayers(1);
+    scanPlayerPlayersCollisions(0, rows, partialT, playerPlayerCollisions, collisions, earlierT, impactScratch[0], awake);
+    return;
+  }
+
+  // chunks of consecutive rows with about the same number of pairs
+  int chunks=collisionsPool->size()*ParallelCollisionsChunksPerThread;
+  packImpactPlayers(chunks);
+  long long pairs=0;
+  for(int row=0; row<rows; row++)
+    pairs+=playerPlayersRowPairs(row);
+  collisionsChunkRows.assign(chunks+1, rows);
+  collisionsChunkRows[0]=0;
+  long long done=0;
+  for(int row=0, k=1; (row<rows) && (k<chunks); row++){
+    done+=playerPlayersRowPairs(row);
+    while((k<chunks) && (done*chunks >= pairs*k))
+      collisionsChunkRows[k++]=row+1;
+  }
+
+  collisionsChunkT.assign(chunks, 1.1);
+  if(int(playerPlayerChunkColls.size()) < chunks)
+    playerPlayerChunkColls.resize(chunks);
+  collisionsPool->parallelFor(chunks, [this, partialT, &playerPlayerCollisions, awake](int k){
+    playerPlayerChunkColls[k].clear();
+    scanPlayerPlayersCollisions(collisionsChunkRows[k], collisionsChunkRows[k+1], partialT, playerPlayerCollisions, playerPlayerChunkColls[k], collisionsChunkT[k], impactScratch[k], awake);
+  });
+  for(int k=0; k<chunks; k++)
+    earlierT=std::min(earlierT, collisionsChunkT[k]);
+  for(int k=0; k<chunks; k++)
+    if(collisionsChunkT[k]==earlierT)
+      collisions.insert(collisions.end(), playerPlayerChunkColls[k].begin(), playerPlayerChunkColls[k].end());
+}
+
+// a prediction is stale if any of its moving objects changed motion after it was made
+bool R2Simulator::isPredictionValid(const R2PredictedCollision& c){
+  bool pole= (c.type==R2CollisionType::PoleBall) || (c.type==R2CollisionType::PolePlayer);
+  return (pole || (predictedVersions[c.object1]==c.version1)) && (predictedVersions[c.object2]==c.version2);
+}
+
+// t is relative to the rest of the tick after partialT, as returned by the find functions
+void R2Simulator::predictCollision(R2CollisionType type, int object1, int object2, bool found, R2Scalar t, R2Scalar partialT){
+  if(!found)
+    return;
+  bool pole= (type==R2CollisionType::PoleBall) || (type==R2CollisionType::PolePlayer);
+  predictedCollisions.emplace_back(partialT + t*(R2Scalar(1) - partialT), type, object1, object2, pole ? 0 : predictedVersions[object1], predictedVersions[object2]);
+  std::push_heap(predictedCollisions.begin(), predictedCollisions.end(), std::greater<R2PredictedCollision>());
+}
+
+// predicts the collisions of the objects marked in predictedChanged, each pair once
+void R2Simulator::predictCollisions(R2Scalar partialT){
+  int t1size=env.teams[0].size();
+  int players=shuffledPlayers.size();
+  int ball=players;
+  bool ballChanged=predictedChanged[ball] && !env.ballCatched;
+  if(ballChanged){
+    if(env.ball.velocity.len()>0.0){
+      for(int i=0; i<4; i++){
+        auto[found, t]= findPoleBallCollision(pitch.poles[i], partialT);
+        if(found){ // can collide against only a pole at once
+          predictCollision(R2CollisionType::PoleBall, i, ball, found, t, partialT);
+          break;
         }
       }
-
     }
-  return collisions;
+    for(int p=0; p<players; p++){
+      auto[found, t]= findBallPlayerCollision(int(p>=t1size), p-int(p>=t1size)*t1size, partialT);
+      predictCollision(R2CollisionType::BallPlayer, p, ball, found, t, partialT);
+    }
+  }
+  for(int p=0; p<players; p++){
+    if(!predictedChanged[p])
+      continue;
+    int w=int(p>=t1size);
+    int n=p-w*t1size;
+    for(int i=0; i<4; i++){
+      auto[found, t]= findPolePlayerCollision(w, n, pitch.poles[i], partialT);
+      if(found){ // can collide against only a pole at once
+        predictCollision(R2CollisionType::PolePlayer, i, p, found, t, partialT);
+        break;
+      }
+    }
+    if(!ballChanged && !env.ballCatched){
+      auto[found, t]= findBallPlayerCollision(w, n, partialT);
+      predictCollision(R2CollisionType::BallPlayer, p, ball, found, t, partialT);
+    }
+    for(int q=0; q<players; q++){
+      if((q==p) || (predictedChanged[q] && (q<p)))  // already predicted with q
+        continue;
+      int first=std::min(p, q), second=std::max(p, q);
+      auto[found, t]= findPlayerPlayerCollision(int(first>=t1size), first-int(first>=t1size)*t1size, int(second>=t1size), second-int(second>=t1size)*t1size, partialT);
+      predictCollision(R2CollisionType::PlayerPlayer, first, second, found, t, partialT);
+    }
+  }
+}
+
+// all the collisions of the tick, from its beginning
+void R2Simulator::startPredictedCollisions(){
+  predictedCollisions.clear();
+  for(auto& v : predictedVersions)
+    v++;
+  std::fill(predictedChanged.begin(), predictedChanged.end(), 1);
+  predictCollisions(0.0);
 }
 
-std::vector<R2PlayerPlayerCollision> R2Simulator::findFirstPlayerPlayersCollisions(double partialT, std::vector<int>& playerPlayerCollisions){
-  std::vector<R2PlayerPlayerCollision> collisions;
+// pops the earliest valid predictions, all those at the same time, and gives them in the same form and order as the find functions
+void R2Simulator::nextPredictedCollisions(R2Scalar partialT, R2PoleBallCollision& poleBall, std::vector<R2PolePlayerCollision>& polePlayers,
+    std::vector<R2BallPlayerCollision>& ballPlayers, std::vector<R2PlayerPlayerCollision>& playerPlayers){
   int t1size=env.teams[0].size();
-  double earlierT=1.1;
-  for(int w1=0; w1<=1; w1++){
-    int l1= env.teams[w1].size();
-    for(int w2=0; w2<=1; w2++){
-      if( w1 && (!w2) ) // do not check twice the collision betwenn the two teams
-        continue;
-      int l2= env.teams[w2].size();
-        for(int n1=0; n1<l1; n1++){
-          int start2 = (w1 == w2) ? (n1+1) : 0 ;
-          for(int n2=start2; n2<l2; n2++){
-              if(playerPlayerCollisions[w1*t1size+n1]!= (w2*t1size+n2) ){ // only if not just prior collision
-                auto[found, t]= findPlayerPlayerCollision(w1, n1, w2, n2, partialT);
-                if(found){ 
-                  if(t<earlierT){
-                    collisions.clear();
-                  }
-                  if(t<=earlierT){
-                    earlierT=t;
-                    R2PlayerPlayerCollision collision(t, n1, w1, n2, w2);
-                    collisions.push_back(collision);
-                  }
-                }
-              }
-          }
-        }
+  std::vector<int>& playerPlayerCollisions=lastPlayerPlayerCollisions;
+  auto applicable=[&](const R2PredictedCollision& c){
+    if(!isPredictionValid(c))
+      return false;
+    if((c.type==R2CollisionType::PoleBall) || (c.type==R2CollisionType::BallPlayer)){
+      if(env.ballCatched)
+        return false;
+      if((c.type==R2CollisionType::BallPlayer) && ballPlayerBlacklist[c.object1])
+        return false;
+    }
+    if(c.type==R2CollisionType::PlayerPlayer)
+      return playerPlayerCollisions[c.object1]!=c.object2; // only if not just prior collision
+    return true;
+  };
+
+  predictedTies.clear();
+  while(!predictedCollisions.empty()){
+    const R2PredictedCollision& c=predictedCollisions.front();
+    if(!predictedTies.empty() && (c.t!=predictedTies[0].t))
+      break;
+    if(applicable(c))
+      predictedTies.push_back(c);
+    std::pop_heap(predictedCollisions.begin(), predictedCollisions.end(), std::greater<R2PredictedCollision>());
+    predictedCollisions.pop_back();
+  }
+  if(predictedTies.empty())
+    return;
+
+  // the order of the serial search: by type, then by the order of the scan
+  auto block=[&](const R2PredictedCollision& c){ return int(c.object1>=t1size) + int(c.object2>=t1size); };
+  std::sort(predictedTies.begin(), predictedTies.end(), [&](const R2PredictedCollision& a, const R2PredictedCollision& b){
+    if(a.type!=b.type)
+      return int(a.type)<int(b.type);
+    if(a.type==R2CollisionType::PolePlayer)
+      return a.object2<b.object2;
+    if((a.type==R2CollisionType::PlayerPlayer) && (block(a)!=block(b)))
+      return block(a)<block(b);
+    return (a.object1<b.object1) || ((a.object1==b.object1) && (a.object2<b.object2));
+  });
+
+  R2Scalar t= std::max(R2Scalar(0), (predictedTies[0].t - partialT)/(R2Scalar(1) - partialT));
+  for(auto& c : predictedTies){
+    if(c.type==R2CollisionType::PoleBall){
+      poleBall=R2PoleBallCollision(true, t, c.object1);
+    }
+    else if(c.type==R2CollisionType::PolePlayer){
+      polePlayers.push_back(R2PolePlayerCollision(t, c.object2-int(c.object2>=t1size)*t1size, int(c.object2>=t1size), c.object1));
+    }
+    else if(c.type==R2CollisionType::BallPlayer){
+      ballPlayers.push_back(R2BallPlayerCollision(t, c.object1-int(c.object1>=t1size)*t1size, int(c.object1>=t1size)));
+    }
+    else{
+      playerPlayers.push_back(R2PlayerPlayerCollision(t, c.object1-int(c.object1>=t1size)*t1size, int(c.object1>=t1size),
+        c.object2-int(c.object2>=t1size)*t1size, int(c.object2>=t1size)));
     }
   }
-  return collisions;
+}
+
+// motion of players and ball right before the collisions are handled
+void R2Simulator::snapshotPredictedObjects(){
+  int t1size=env.teams[0].size();
+  int players=shuffledPlayers.size();
+  for(int p=0; p<players; p++){
+    int w= int(p>=t1size);
+    const R2PlayerInfo& info=env.teams[w][p - w*t1size];
+    predictedSnapshot[2*p]=info.pos;
+    predictedSnapshot[2*p+1]=info.velocity;
+  }
+  predictedSnapshot[2*players]=env.ball.pos;
+  predictedSnapshot[2*players+1]=env.ball.velocity;
+}
+
+// the objects involved in the handled collisions, or moved by the handling (e.g. anti bouncing, ball inside players), get new predictions
+void R2Simulator::updatePredictedCollisions(R2Scalar partialT, const R2PoleBallCollision& poleBall, const std::vector<R2PolePlayerCollision>& polePlayers,
+    const std::vector<R2BallPlayerCollision>& ballPlayers, const std::vector<R2PlayerPlayerCollision>& playerPlayers){
+  int t1size=env.teams[0].size();
+  int players=shuffledPlayers.size();
+  auto moved=[&](const R2ObjectInfo& o, int index){
+    const Vec2& pos=predictedSnapshot[2*index];
+    const Vec2& velocity=predictedSnapshot[2*index+1];
+    return (o.pos.x!=pos.x) || (o.pos.y!=pos.y) || (o.velocity.x!=velocity.x) || (o.velocity.y!=velocity.y);
+  };
+  for(int p=0; p<players; p++)
+    predictedChanged[p]=moved(env.teams[int(p>=t1size)][p-int(p>=t1size)*t1size], p);
+  predictedChanged[players]=moved(env.ball, players);
+
+  if(poleBall.collision || !ballPlayers.empty())
+    predictedChanged[players]=1;
+  for(auto& c : polePlayers)
+    predictedChanged[c.team*t1size+c.p]=1;
+  for(auto& c : ballPlayers)
+    predictedChanged[c.team*t1size+c.p]=1;
+  for(auto& c : playerPlayers){
+    predictedChanged[c.team1*t1size+c.p1]=1;
+    predictedChanged[c.team2*t1size+c.p2]=1;
+  }
+
+  for(int i=0; i<=players; i++)
+    if(predictedChanged[i])
+      predictedVersions[i]++;
+  predictCollisions(partialT);
+}
+
+void R2Simulator::setCollisionThreads(int threads, int minPlayers){
+  collisionsMinPlayers=minPlayers;
+  if(threads>1)
+    collisionsPool=std::make_unique<R2ThreadPool>(threads);
+  else
+    collisionsPool.reset();
 }
 
 // updates motion up to t
-void R2Simulator::updateMotion(double t){
+void R2Simulator::updateMotion(R2Scalar t){
   env.ball.pos+=env.ball.velocity*t;
   for(int w=0; w<=1; w++)
     for(auto& p: env.teams[w]){
@@ -1152,7 +1707,9 @@ void R2Simulator::updateMotion(double t){
 } 
 
 void R2Simulator::addBallNoise(){
-  Vec2 noise=  Vec2((normalDist(rng)-0.5)*fabs(env.ball.velocity.x), (normalDist(rng)-0.5)*fabs(env.ball.velocity.y))*sett.playerRandomNoise;
+  R2Scalar noiseY=randomNormal(R2RandomPurpose::BallNoise);  // y first: the order in which gcc evaluated them when they were drawn inside the Vec2 constructor call
+  R2Scalar noiseX=randomNormal(R2RandomPurpose::BallNoise);
+  Vec2 noise=  Vec2((noiseX-0.5)*fabs(env.ball.velocity.x), (noiseY-0.5)*fabs(env.ball.velocity.y))*sett.playerRandomNoise;
   Vec2 newPos= env.ball.pos + noise;
 
   for(int w=0; w<=1; w++)
@@ -1174,45 +1731,157 @@ bool R2Simulator::checkGoalOrBallOut(){
           env.score2 += 1;
           env.state = R2State::Goal2;
           env.ball.velocity.zero();
+          events.goals[1]++;
           return true;
   }
   else if (isGoalScored(true)) {
           env.score1 += 1;
           env.state = R2State::Goal1;
           env.ball.velocity.zero();
+          events.goals[0]++;
           return true;
   }
   
-  return checkBallOut();
+  if(checkBallOut()){
+    events.ballOut++;
+    return true;
+  }
+  return false;
+}
+
+// The kinds of collisions that may happen in the tick, as bits 1<<R2CollisionType, with a conservative test. Two objects cannot meet
+// (the time of impact search finds nothing in the tick, and they do not overlap at its end) if their distance is greater than the sum of
+// their radiuses plus QuietReachFactor times their displacement in the tick (the search needs at least 1+sqrt(2), because of the
+// approximations of intersectionSegmentCircle()) plus QuietReachMargin. The objects are swept along x, so that the far ones and the
+// still ones, whose reach is little more than their radius, are not even paired: most ticks need only a few distances.
+// It also marks in sweepAwake the players that may meet another player.
+unsigned R2Simulator::possibleCollisions(){
+  int t1size=env.teams[0].size();
+  int players=shuffledPlayers.size();
+  int ball=players;
+  int objects=players+1+4;
+  sweepPos.resize(objects);
+  sweepReach.resize(objects);
+  sweepAwake.assign(players, 0);
+  for(int i=0; i<players; i++){
+    int w=int(i>=t1size);
+    R2ObjectInfo& p=env.teams[w][i-w*t1size];
+    sweepPos[i]=p.pos;
+    sweepReach[i]=sett.playerRadius + p.velocity.len()*QuietReachFactor + QuietReachMargin;
+  }
+  sweepPos[ball]=env.ball.pos;
+  sweepReach[ball]=sett.ballRadius + env.ball.velocity.len()*QuietReachFactor + QuietReachMargin;
+  for(int i=0; i<4; i++){
+    sweepPos[ball+1+i]=pitch.poles[i];
+    sweepReach[ball+1+i]=sett.poleRadius + QuietReachMargin;
+  }
+
+  if(int(sweepOrder.size())!=objects){
+    sweepOrder.resize(objects);
+    std::iota(sweepOrder.begin(), sweepOrder.end(), 0);
+  }
+  auto left=[&](int o){ return sweepPos[o].x - sweepReach[o]; };
+  for(int i=1; i<objects; i++){   // insertion sort: objects move little from a tick to the next, so the order is almost sorted already
+    int o=sweepOrder[i];
+    R2Scalar l=left(o);
+    int j=i;
+    for(; (j>0) && (left(sweepOrder[j-1])>l); j--)
+      sweepOrder[j]=sweepOrder[j-1];
+    sweepOrder[j]=o;
+  }
+
+  auto kind=[&](int o){ return (o<players) ? 0 : ( (o==ball) ? 1 : 2 ); };  // player, ball, pole
+  const R2CollisionType types[3][3]={
+    {R2CollisionType::PlayerPlayer, R2CollisionType::BallPlayer, R2CollisionType::PolePlayer},
+    {R2CollisionType::BallPlayer, R2CollisionType::None, R2CollisionType::PoleBall},
+    {R2CollisionType::PolePlayer, R2CollisionType::PoleBall, R2CollisionType::None}};
+  unsigned possible=0;
+  for(int i=0; i<objects; i++){
+    int o1=sweepOrder[i];
+    R2Scalar right=sweepPos[o1].x + sweepReach[o1];
+    for(int j=i+1; (j<objects) && (left(sweepOrder[j])<=right); j++){
+      int o2=sweepOrder[j];
+      R2CollisionType type=types[kind(o1)][kind(o2)];
+      unsigned bit=1u<<int(type);
+      if((type==R2CollisionType::None) || ((possible & bit) && (type!=R2CollisionType::PlayerPlayer)))
+        continue;
+      if(env.ballCatched && ((o1==ball) || (o2==ball)))  // the ball is not searched
+        continue;
+      Vec2 d=sweepPos[o1]-sweepPos[o2];
+      R2Scalar reach=sweepReach[o1]+sweepReach[o2];
+      if(d.x*d.x + d.y*d.y <= reach*reach){
+        possible|=bit;
+        if(type==R2CollisionType::PlayerPlayer)
+          sweepAwake[o1]=sweepAwake[o2]=1;
+      }
+    }
+  }
+  return possible;
 }
 
 void R2Simulator::manageCollisions(){
-  double partialT= 0.0;
+  R2S_PROFILE_PHASE(R2Phase::ManageCollisions);
+  R2Scalar partialT= 0.0;
   bool collisions=true;
   int count=0;
-  double addT=0.0;
+  R2Scalar addT=0.0;
 
   int t1size=env.teams[0].size();
   int t2size=env.teams[1].size();
 
-  std::vector<int> playerPlayerCollisions(t1size+t2size, -1);
-  std::vector<bool>  ballPlayerBlacklist(t1size+t2size, false);
+  std::vector<int>& playerPlayerCollisions=lastPlayerPlayerCollisions;
+  playerPlayerCollisions.assign(t1size+t2size, -1);
+  ballPlayerBlacklist.assign(t1size+t2size, false);
+  earlierCollisions.reserve(4);   // so that the first tick with a collision of some kind does not allocate
+  firstPolePlayersColls.reserve(t1size+t2size);
+  firstBallPlayerColls.reserve(t1size+t2size);
+  firstPlayerPlayerColls.reserve(t1size+t2size);
 
   int ballPlayersColls[MaxCollisionInsideTickLoop]; 
   int ballPlayersCollsTeam[MaxCollisionInsideTickLoop]; 
   int howManyBallPlayersColls=0;
+  unsigned possible= quiescenceEarlyOut ? possibleCollisions() : ~0u;  // valid until the first collision is handled
+  auto mayCollide=[&](R2CollisionType type){ return (possible & (1u<<int(type))) != 0; };
+  bool handled=false;
+  if(possible==0)
+    physics.quietTicks++;
+  if(eventDrivenCollisions && possible)
+    startPredictedCollisions();
   while(collisions && (count <MaxCollisionInsideTickLoop) && (partialT<1.0) ){
     collisions=false;
-    std::vector<R2CollisionTime> earlierCollisionsTypes;
+    std::vector<R2CollisionTime>& earlierCollisionsTypes=earlierCollisions;
+    earlierCollisionsTypes.clear();
 
     R2PoleBallCollision newPoleBallColl(false, 0.0, 0);
+    std::vector<R2PolePlayerCollision>& newPolePlayersColls=firstPolePlayersColls;
+    std::vector<R2BallPlayerCollision>& newBallPlayerColls=firstBallPlayerColls;
+    std::vector<R2PlayerPlayerCollision>& newPlayerPlayerColls=firstPlayerPlayerColls;
+    newPolePlayersColls.clear();
+    newBallPlayerColls.clear();
+    newPlayerPlayerColls.clear();
+    if(eventDrivenCollisions){
+      if(possible)
+        nextPredictedCollisions(partialT, newPoleBallColl, newPolePlayersColls, newBallPlayerColls, newPlayerPlayerColls);
+    }
+    else{
+      if(!env.ballCatched && (handled || mayCollide(R2CollisionType::PoleBall)))
+        newPoleBallColl=findFirstPoleBallCollision(partialT);
+      if(handled || mayCollide(R2CollisionType::PolePlayer))
+        findFirstPolePlayersCollisions(partialT, newPolePlayersColls);
+      if(!env.ballCatched && (handled || mayCollide(R2CollisionType::BallPlayer)))
+        findFirstBallPlayersCollisions(partialT, ballPlayerBlacklist, newBallPlayerColls);
+      if(handled)
+        findFirstPlayerPlayersCollisions(partialT, playerPlayerCollisions, newPlayerPlayerColls);
+      else if(mayCollide(R2CollisionType::PlayerPlayer))
+        findFirstPlayerPlayersCollisions(partialT, playerPlayerCollisions, newPlayerPlayerColls, quiescenceEarlyOut ? &sweepAwake : nullptr);
+    }
+
     if(!env.ballCatched){
-      newPoleBallColl=findFirstPoleBallCollision(partialT);
       if((newPoleBallColl.collision)&&(env.ball.velocity.len()>0.0)){
         collisions|=newPoleBallColl.collision;
 
         if(earlierCollisionsTypes.size()>0){
-          double earlierT=earlierCollisionsTypes[0].t;
+          R2Scalar earlierT=earlierCollisionsTypes[0].t;
           if(newPoleBallColl.t<earlierT){
             earlierCollisionsTypes.clear();
           }
@@ -1228,16 +1897,15 @@ void R2Simulator::manageCollisions(){
       }
     }
 
-    std::vector<R2PolePlayerCollision> newPolePlayersColls= findFirstPolePlayersCollisions(partialT);
     bool collPolePlayers=(newPolePlayersColls.size()>0);
     collisions|=collPolePlayers;
-    double kPolePlayers=0.0;
+    R2Scalar kPolePlayers=0.0;
     if(collPolePlayers){
      kPolePlayers=newPolePlayersColls[0].t;
     }
     if(collPolePlayers){
       if(earlierCollisionsTypes.size()>0){
-        double earlierT=earlierCollisionsTypes[0].t;
+        R2Scalar earlierT=earlierCollisionsTypes[0].t;
         if(kPolePlayers<earlierT){
           earlierCollisionsTypes.clear();
         }
@@ -1252,18 +1920,16 @@ void R2Simulator::manageCollisions(){
       }
     }
 
-    std::vector<R2BallPlayerCollision> newBallPlayerColls;
     if(!env.ballCatched){
-      newBallPlayerColls=findFirstBallPlayersCollisions(partialT, ballPlayerBlacklist);
       bool collBall=(newBallPlayerColls.size()>0);
-      double kBall=0.0;
+      R2Scalar kBall=0.0;
       if(collBall){
         kBall=newBallPlayerColls[0].t;
       }
       collisions|=collBall;
       if(collBall){
         if(earlierCollisionsTypes.size()>0){
-          double earlierT=earlierCollisionsTypes[0].t;
+          R2Scalar earlierT=earlierCollisionsTypes[0].t;
           if(kBall<earlierT){
             earlierCollisionsTypes.clear();
           }
@@ -1279,9 +1945,8 @@ void R2Simulator::manageCollisions(){
       }
     }
 
-    std::vector<R2PlayerPlayerCollision> newPlayerPlayerColls=findFirstPlayerPlayersCollisions(partialT, playerPlayerCollisions);
     bool collPlayers=(newPlayerPlayerColls.size()>0);
-    double kPlayers=0.0;
+    R2Scalar kPlayers=0.0;
     if(collPlayers){
       kPlayers=newPlayerPlayerColls[0].t;
     }
@@ -1289,7 +1954,7 @@ void R2Simulator::manageCollisions(){
 
     if(collPlayers){
       if(earlierCollisionsTypes.size()>0){
-        double earlierT=earlierCollisionsTypes[0].t;
+        R2Scalar earlierT=earlierCollisionsTypes[0].t;
         if(kPlayers<earlierT){
           earlierCollisionsTypes.clear();
         }
@@ -1305,9 +1970,12 @@ void R2Simulator::manageCollisions(){
     }
 
     if(collisions){
-      double earlierT=earlierCollisionsTypes[0].t;
-      addT=earlierT*(1.0 - partialT);
+      handled=true;
+      R2Scalar earlierT=earlierCollisionsTypes[0].t;
+      addT=earlierT*(R2Scalar(1) - partialT);
       updateMotion(addT);
+      if(eventDrivenCollisions)
+        snapshotPredictedObjects();
 
       for(auto& co: earlierCollisionsTypes){
         if(co.type==R2CollisionType::BallPlayer){
@@ -1330,33 +1998,37 @@ void R2Simulator::manageCollisions(){
                 p1.velocity.zero();
                 auto& p2= env.teams[int(ballPlayersCollsTeam[howManyBallPlayersColls-2])][ballPlayersColls[howManyBallPlayersColls-2]];
                 p2.velocity.zero();
+                physics.antiBounces++;
 
                 count++;
                 continue;
               }
             }
             env.lastTouchedTeam2=bool(bpcoll.team);
+            events.touches[bpcoll.team]++;
+            physics.collisions[int(R2CollisionType::BallPlayer)]++;
             //let's change ball velocity
             auto& p= env.teams[bpcoll.team][bpcoll.p];
             Vec2 v=env.ball.velocity - p.velocity;
-            double vel=v.len();
+            R2Scalar vel=v.len();
             Vec2 d=env.ball.pos - p. pos;
             if( ((v.x==0.0)&&(v.y==0.0)) || ((d.x==0.0)&&(d.y==0.0)) ){  // this happens if the ball is moving exactly at the same velocity as the player, they just intersected and floating numbers have some rounding errors
               // blacklist the player so it won't be checked continuously for the collision
               ballPlayerBlacklist[t1size*bpcoll.team+bpcoll.p]=true;
+              physics.ballPlayerBlacklists++;
               count++;
               continue;
             }
-            double impactAngle=atan2(d.y, d.x); // angle of the impact point on the player's circle wrt to player center
-            double trajectoryAngle=atan2(v.y, v.x); // ball trajectory angle is the same as ball velocity direction, with inverted sign to have it on the same orientation of the d vector
-            double reflectedAngle=impactAngle + remainder(impactAngle-trajectoryAngle, M_PI);
+            R2Scalar impactAngle=fatan2(d.y, d.x); // angle of the impact point on the player's circle wrt to player center
+            R2Scalar trajectoryAngle=fatan2(v.y, v.x); // ball trajectory angle is the same as ball velocity direction, with inverted sign to have it on the same orientation of the d vector
+            R2Scalar reflectedAngle=impactAngle + fremainder(impactAngle-trajectoryAngle, M_PI);
           
-            double rX=cos(reflectedAngle);
-            double rY=sin(reflectedAngle);
+            R2Scalar rX, rY;
+            fsincos(reflectedAngle, rY, rX);
             
             if(vel > 0.0){
               if(! sett.simplified){
-                if( fabs(remainder(p.direction-impactAngle, 2*M_PI)) < KickableAngle ){  // bounces on the back of a player, stopped in front of the player
+                if( fabs(fremainder(p.direction-impactAngle, 2*M_PI)) < KickableAngle ){  // bounces on the back of a player, stopped in front of the player
                   env.ball.velocity.x=p.velocity.x*BallPlayerHitFactor +rX*vel*BallPlayerStopFactor;
                   env.ball.velocity.y=p.velocity.y*BallPlayerHitFactor +rY*vel*BallPlayerStopFactor;
                 }
@@ -1366,7 +2038,7 @@ void R2Simulator::manageCollisions(){
                 }
               }
               else{ // simplified model
-                if( fabs(remainder(p.direction-impactAngle, 2*M_PI)) < KickableAngle ){  // bounces on the back of a player, stopped in front of the player
+                if( fabs(fremainder(p.direction-impactAngle, 2*M_PI)) < KickableAngle ){  // bounces on the back of a player, stopped in front of the player
                   env.ball.velocity.x=p.velocity.x*BallPlayerHitFactorSimplified;
                   env.ball.velocity.y=p.velocity.y*BallPlayerHitFactorSimplified;
                 }
@@ -1380,6 +2052,7 @@ void R2Simulator::manageCollisions(){
         }
         else if(co.type==R2CollisionType::PlayerPlayer){
           for(auto ppcoll:newPlayerPlayerColls){
+            physics.collisions[int(R2CollisionType::PlayerPlayer)]++;
             playerPlayerCollisions[ppcoll.team1*t1size+ppcoll.p1]=ppcoll.team2*t1size+ppcoll.p2;  // take note of collision
             playerPlayerCollisions[ppcoll.team2*t1size+ppcoll.p2]=ppcoll.team1*t1size+ppcoll.p1;
 
@@ -1390,15 +2063,15 @@ void R2Simulator::manageCollisions(){
             // modification to the first player
             Vec2 v1=p1.velocity - p2.velocity;  // velocity of p1 wrt p2 (just like p2 was still), that is total velocity of p1 impacting AGAINST p2
             Vec2 d1=p2.pos - p1.pos;
-            double transmission=v1.cosBetween(d1) *0.5;  // the more the impact angle (depending on impact point, or the centers) coincides with the resulting relative velocity, the more the energy is transferred to the impact. It has to be divided by two (an half for each player)
-            double momentum=v1.len()*transmission;  // the momentum depends on the resulting velocity magnitude, on the transmission
+            R2Scalar transmission=v1.cosBetween(d1) *R2Scalar(0.5);  // the more the impact angle (depending on impact point, or the centers) coincides with the resulting relative velocity, the more the energy is transferred to the impact. It has to be divided by two (an half for each player)
+            R2Scalar momentum=v1.len()*transmission;  // the momentum depends on the resulting velocity magnitude, on the transmission
             // a part of inverted velocity goes to acceleration/deceleration depending on how much the direction coincides with the player direction
             Vec2 v2=v1*(-1);  // actual velocity vector of the impact AGAINST p1
             Vec2 dir1= Vec2(p1.direction) ;
-            double accelPart1=v2.cosBetween(dir1);  // part of momentum to be used to accelerate/decelerate the player because aligned with its direction (the other part would displace a little the player)
+            R2Scalar accelPart1=v2.cosBetween(dir1);  // part of momentum to be used to accelerate/decelerate the player because aligned with its direction (the other part would displace a little the player)
 
             Vec2 dir2= Vec2(p2.direction) ;
-            double accelPart2=v1.cosBetween(dir2);
+            R2Scalar accelPart2=v1.cosBetween(dir2);
 
             Vec2 accel1= dir1 * accelPart1 * momentum;
             Vec2 accel2= dir2 * accelPart2 * momentum;
@@ -1442,12 +2115,12 @@ void R2Simulator::manageCollisions(){
             // cancel only the frontal crash velocity component and not all the velocity: it results in a lesser blocking of players than the commented mechanisms above 
             d1.resize(1.0);
             Vec2 d2=d1*-1;
-            double cosV1=d1.cosBetween(p1.velocity);
+            R2Scalar cosV1=d1.cosBetween(p1.velocity);
             if(cosV1>0.0){
               Vec2 toSub=d1*cosV1*p1.velocity.len();  // projection of p1 velocity onto the line connecting p1 and 2
               p1.velocity -= toSub;                   // subtract the crash direction component of the velocity
             }
-            double cosV2=d2.cosBetween(p2.velocity);
+            R2Scalar cosV2=d2.cosBetween(p2.velocity);
             if(cosV2>0.0){
               Vec2 toSub=d2*cosV2*p2.velocity.len();  // projection of p2 velocity onto the line connecting p1 and 2
               p2.velocity -= toSub;                   // subtract the crash direction component of the velocity
@@ -1455,22 +2128,24 @@ void R2Simulator::manageCollisions(){
           }
         }
         else if(co.type==R2CollisionType::PoleBall){
+          physics.collisions[int(R2CollisionType::PoleBall)]++;
           Vec2 pole=pitch.poles[newPoleBallColl.pole];
 
-          double vel=env.ball.velocity.len();
+          R2Scalar vel=env.ball.velocity.len();
           Vec2 d=env.ball.pos - pole;
 
-          double impactAngle=atan2(d.y, d.x); // angle of the impact point on the pole circle wrt to pole center
-          double trajectoryAngle=atan2(env.ball.velocity.y, env.ball.velocity.x); 
-          double reflectedAngle=impactAngle + remainder(impactAngle-trajectoryAngle, M_PI);
-          double rX=cos(reflectedAngle);
-          double rY=sin(reflectedAngle);
+          R2Scalar impactAngle=fatan2(d.y, d.x); // angle of the impact point on the pole circle wrt to pole center
+          R2Scalar trajectoryAngle=fatan2(env.ball.velocity.y, env.ball.velocity.x); 
+          R2Scalar reflectedAngle=impactAngle + fremainder(impactAngle-trajectoryAngle, M_PI);
+          R2Scalar rX, rY;
+          fsincos(reflectedAngle, rY, rX);
           env.ball.velocity.x=rX*vel*BallPoleBounceFactor;
           env.ball.velocity.y=rY*vel*BallPoleBounceFactor;
           
         }
         else if(co.type==R2CollisionType::PolePlayer){
             for(auto ppcoll: newPolePlayersColls){
+              physics.collisions[int(R2CollisionType::PolePlayer)]++;
               auto& p1= env.teams[ppcoll.team][ppcoll.p];
               p1.velocity.zero();
 
@@ -1493,7 +2168,8 @@ void R2Simulator::manageCollisions(){
     }
     else {
       oldEnv = env;
-      manageBallInsidePlayers();
+      if(handled || mayCollide(R2CollisionType::BallPlayer))  // otherwise nothing moved yet, and the ball is far from the players
+        manageBallInsidePlayers();
       if(checkGoalOrBallOut()) {
         collisions=false;
       }
@@ -1501,20 +2177,30 @@ void R2Simulator::manageCollisions(){
         oldEnv = env;
       }
     }
+    if(eventDrivenCollisions && collisions)
+      updatePredictedCollisions(partialT, newPoleBallColl, newPolePlayersColls, newBallPlayerColls, newPlayerPlayerColls);
   }
 
+  physics.subSteps[std::min(count, MaxCollisionInsideTickLoop)]++;
+  if(collisions && (count >=MaxCollisionInsideTickLoop) && (partialT<1.0))
+    physics.collisionsLoopCapHits++;
+
   if(env.ballCatched){
     setBallCatchedPosition();
   }
+  // players moved at most by their displacement of the tick, so they cannot overlap if they could not meet
+  quietPlayers= !handled && !mayCollide(R2CollisionType::PlayerPlayer) && !mayCollide(R2CollisionType::PolePlayer);
+  bool quietBall= !handled && !mayCollide(R2CollisionType::BallPlayer) && (env.ball.velocity.x==0.0) && (env.ball.velocity.y==0.0);  // no noise either
 
   //final series of checks
   if (env.state == R2State::Play) {
-      updateMotion(1.0 - partialT); // the rest of the tick has to be completed
+      updateMotion(R2Scalar(1) - partialT); // the rest of the tick has to be completed
       addBallNoise();
 
       if (! checkGoalOrBallOut()) {
           oldEnv = env;
-          manageBallInsidePlayers();
+          if(!quietBall)
+            manageBallInsidePlayers();
           if (! checkGoalOrBallOut()) {
             oldEnv = env;
           }
@@ -1523,7 +2209,7 @@ void R2Simulator::manageCollisions(){
 }
 
 void R2Simulator::manageBallInsidePlayers(){
-  const double radius=sett.playerRadius+sett.ballRadius;
+  const R2Scalar radius=sett.playerRadius+sett.ballRadius;
   if(env.ballCatched)
     return;
   bool collisions=true;
@@ -1533,7 +2219,7 @@ void R2Simulator::manageBallInsidePlayers(){
     {
       Vec2 d=env.ball.pos - p.pos;
 
-      double len=d.len();
+      R2Scalar len=d.len();
       if((len+R2SmallEpsilon)< radius){
         collisions=true;
 
@@ -1554,11 +2240,16 @@ void R2Simulator::manageBallInsidePlayers(){
     checkCol(1);
     count ++;
   }
+  if((count>1) || collisions)
+    physics.ballInsidePlayersActivations++;
+  if(collisions)
+    physics.ballInsidePlayersCapHits++;
 }
 
 void R2Simulator::updateCollisionsAndMovements(){
   manageCollisions();
-  manageStaticPlayersCollisions();
+  if(!quietPlayers)
+    manageStaticPlayersCollisions();
 }
 
 // here in case of collision the player is moved
@@ -1574,15 +2265,15 @@ void R2Simulator::manageStaticBallCollisions(){
         auto [dist, d]=p.dist(env.ball); 
         if(dist<R2Epsilon) {
           collisions=true;
-          double angle=uniformDist(rng)*2*M_PI;
-          double sx=cos(angle)*(sett.playerRadius+sett.ballRadius);
-          double sy=sin(angle)*(sett.playerRadius+sett.ballRadius);
+          R2Scalar angle=randomUniform(R2RandomPurpose::StaticBall, team, int(&p - env.teams[team].data()))*2*M_PI;
+          R2Scalar sx=fcos(angle)*(sett.playerRadius+sett.ballRadius);
+          R2Scalar sy=fsin(angle)*(sett.playerRadius+sett.ballRadius);
             p.pos.x-=sx;
             p.pos.y-=sy;
         }
         else {
-          double ratio=(sett.playerRadius+sett.ballRadius)/dist;
-          double diff=ratio-1.0;
+          R2Scalar ratio=(sett.playerRadius+sett.ballRadius)/dist;
+          R2Scalar diff=ratio-R2Scalar(1);
           if(diff>0.0){
             collisions=true;
             p.pos.x+=d.x*diff;
@@ -1594,80 +2285,97 @@ void R2Simulator::manageStaticBallCollisions(){
     collisions|=manageStaticPoleBallCollisions();
     count ++;
   }
+  if((count>1) || collisions)
+    physics.staticBallActivations++;
+  if(collisions)
+    physics.staticBallCapHits++;
 }
 
 // player vs player collisions, when the game is inactive
 void R2Simulator::manageStaticPlayersCollisions(){
+  R2S_PROFILE_PHASE(R2Phase::ManageStaticPlayersCollisions);
   bool collisions=true;
+  bool shallow=false;     // overlaps not deeper than staticTolerance have been separated in the last pass
+  const R2Scalar contact=sett.playerRadius*2;
+  const R2Scalar farSquared=contact*contact*R2Scalar(1+StaticFarMargin);
 
   auto checkCol=[&](int t1, int t2){
-    
     int c1=0;
     for(auto& p1: env.teams[t1]){
-      c1++;
-      int c2=0;
       for(auto& p2: env.teams[t2]){
-        c2++;
         if(&p1 == &p2)
           continue;
 
-        auto [dist, d]=p2.dist(p1); 
+        Vec2 d=p1.pos-p2.pos;
+        R2Scalar squared=d.x*d.x + d.y*d.y;
+        if(squared>=farSquared)     // surely not closer than contact, the square root is not needed
+          continue;
+        R2Scalar dist=sqrt(squared);
 
         if(dist<R2Epsilon) {
           collisions=true;
-          double angle=uniformDist(rng)*2*M_PI;
-          double sx=cos(angle)*sett.playerRadius;
-          double sy=sin(angle)*sett.playerRadius;
+          R2Scalar angle=randomUniform(R2RandomPurpose::StaticPlayers, t1, c1)*2*M_PI;
+          R2Scalar sx=fcos(angle)*sett.playerRadius;
+          R2Scalar sy=fsin(angle)*sett.playerRadius;
             p1.pos.x+=sx;
             p1.pos.y+=sy;
             p2.pos.x-=sx;
             p2.pos.y-=sy;
         }
-        else if(dist<sett.playerRadius*2){
-            double ratio=sett.playerRadius*2/dist;
-            collisions=true;
-            double toAdd= ratio-1.0;
+        else if(dist<contact){
+            R2Scalar ratio=contact/dist;
+            if(contact-dist>staticTolerance)
+              collisions=true;
+            else
+              shallow=true;
+            R2Scalar toAdd= ratio-R2Scalar(1);
             
-            p1.pos.x+=d.x*toAdd*0.5;
-            p1.pos.y+=d.y*toAdd*0.5;
-            p2.pos.x-=d.x*toAdd*0.5;
-            p2.pos.y-=d.y*toAdd*0.5;
-
+            p1.pos.x+=d.x*toAdd*R2Scalar(0.5);
+            p1.pos.y+=d.y*toAdd*R2Scalar(0.5);
+            p2.pos.x-=d.x*toAdd*R2Scalar(0.5);
+            p2.pos.y-=d.y*toAdd*R2Scalar(0.5);
         }
-        
       }
+      c1++;
     }
   };
 
   int count=0;
   while(collisions && (count <MaxCollisionLoop)){
     collisions=false;
+    shallow=false;
     checkCol(0, 1);
     checkCol(0, 0);
     checkCol(1, 1);
-    collisions|=manageStaticPolePlayersCollisions();
+    collisions|=manageStaticPolePlayersCollisions(shallow);
     count ++;
   }
+  if((count>1) || collisions)
+    physics.staticPlayersActivations++;
+  if(collisions)
+    physics.staticPlayersCapHits++;
+  else if(shallow)
+    physics.staticPlayersToleranceStops++;
 }
 
 bool R2Simulator::manageStaticPoleBallCollisions(){
-  const double radius=sett.poleRadius+sett.ballRadius;
+  const R2Scalar radius=sett.poleRadius+sett.ballRadius;
 
   for(auto& pole: pitch.poles)
   {
     Vec2 d=env.ball.pos-pole; 
-    double dist=d.len();
+    R2Scalar dist=d.len();
     if(dist<R2Epsilon) {
-      double angle=uniformDist(rng)*2*M_PI;
-      double sx=cos(angle)*radius;
-      double sy=sin(angle)*radius;
+      R2Scalar angle=randomUniform(R2RandomPurpose::StaticPoleBall)*2*M_PI;
+      R2Scalar sx=fcos(angle)*radius;
+      R2Scalar sy=fsin(angle)*radius;
         env.ball.pos.x-=sx;
         env.ball.pos.y-=sy;
         return true;
     }
     else {
-      double ratio=radius/dist;
-      double diff=ratio-1.0;
+      R2Scalar ratio=radius/dist;
+      R2Scalar diff=ratio-R2Scalar(1);
       if(diff>0.0){
         env.ball.pos.x+=d.x*diff;
         env.ball.pos.y+=d.y*diff;
@@ -1678,8 +2386,10 @@ bool R2Simulator::manageStaticPoleBallCollisions(){
   return false;
 }
 
-bool R2Simulator::manageStaticPolePlayersCollisions(){
-  const double radius=sett.poleRadius+sett.playerRadius;
+// sets shallow if it separated overlaps not deeper than staticTolerance
+bool R2Simulator::manageStaticPolePlayersCollisions(bool& shallow){
+  const R2Scalar radius=sett.poleRadius+sett.playerRadius;
+  const R2Scalar farSquared=radius*radius*R2Scalar(1+StaticFarMargin);
   bool collisions=true;
 
   int count=0;
@@ -1692,20 +2402,26 @@ bool R2Simulator::manageStaticPolePlayersCollisions(){
         for(auto& pole: pitch.poles)
         {
           Vec2 d=p.pos-pole; 
-          double dist=d.len();
+          R2Scalar squared=d.x*d.x + d.y*d.y;
+          if(squared>=farSquared)
+            continue;
+          R2Scalar dist=sqrt(squared);
           if(dist<R2Epsilon) {
             collisions=true;
-            double angle=uniformDist(rng)*2*M_PI;
-            double sx=cos(angle)*radius;
-            double sy=sin(angle)*radius;
+            R2Scalar angle=randomUniform(R2RandomPurpose::StaticPolePlayers, team, int(&p - env.teams[team].data()))*2*M_PI;
+            R2Scalar sx=fcos(angle)*radius;
+            R2Scalar sy=fsin(angle)*radius;
               p.pos.x-=sx;
               p.pos.y-=sy;
           }
           else {
-            double ratio=radius/dist;
-            double diff=ratio-1.0;
+            R2Scalar ratio=radius/dist;
+            R2Scalar diff=ratio-R2Scalar(1);
             if(diff>0.0){
-              collisions=true;
+              if(dist*diff>staticTolerance)
+                collisions=true;
+              else
+                shallow=true;
               p.pos.x+=d.x*diff;
               p.pos.y+=d.y*diff;
             }
@@ -1715,248 +2431,236 @@ bool R2Simulator::manageStaticPolePlayersCollisions(){
 
     count ++;
   }
+  if((count>1) || collisions)
+    physics.staticPolePlayersActivations++;
+  if(collisions)
+    physics.staticPolePlayersCapHits++;
   return collisions;
 }
 
+const R2Simulator::R2StateHandlers R2Simulator::stateHandlers[R2StateCount+1]={
+  {nullptr, nullptr, nullptr},    // Inactive
+  {nullptr, nullptr, &R2Simulator::procReady},  // Ready, currently unused
+  {&R2Simulator::preKickoff, &R2Simulator::checkKickoff, &R2Simulator::procKickoff},  // Kickoff1
+  {&R2Simulator::preKickoff, &R2Simulator::checkKickoff, &R2Simulator::procKickoff},  // Kickoff2
+  {&R2Simulator::prePlay, &R2Simulator::checkPlay, &R2Simulator::procPlay},  // Play
+  {&R2Simulator::preStopped, nullptr, nullptr},  // Stopped, currently unused
+  {&R2Simulator::preGoalkick, &R2Simulator::checkGoalkick, &R2Simulator::procGoalkick},  // Goalkick1up
+  {&R2Simulator::preGoalkick, &R2Simulator::checkGoalkick, &R2Simulator::procGoalkick},  // Goalkick1down
+  {&R2Simulator::preGoalkick, &R2Simulator::checkGoalkick, &R2Simulator::procGoalkick},  // Goalkick2up
+  {&R2Simulator::preGoalkick, &R2Simulator::checkGoalkick, &R2Simulator::procGoalkick},  // Goalkick2down
+  {&R2Simulator::preCorner, &R2Simulator::checkCorner, &R2Simulator::procCorner},  // Corner1up
+  {&R2Simulator::preCorner, &R2Simulator::checkCorner, &R2Simulator::procCorner},  // Corner1down
+  {&R2Simulator::preCorner, &R2Simulator::checkCorner, &R2Simulator::procCorner},  // Corner2up
+  {&R2Simulator::preCorner, &R2Simulator::checkCorner, &R2Simulator::procCorner},  // Corner2down
+  {&R2Simulator::preThrowin, &R2Simulator::checkThrowin, &R2Simulator::procThrowin},  // Throwin1
+  {&R2Simulator::preThrowin, &R2Simulator::checkThrowin, &R2Simulator::procThrowin},  // Throwin2
+  {nullptr, nullptr, nullptr},    // Paused, currently unused
+  {&R2Simulator::preHalftime, nullptr, nullptr},  // Halftime
+  {nullptr, &R2Simulator::checkGoal, &R2Simulator::procGoal},  // Goal1
+  {nullptr, &R2Simulator::checkGoal, &R2Simulator::procGoal},  // Goal2
+  {nullptr, nullptr, &R2Simulator::procEnded},  // Ended
+  {nullptr, nullptr, nullptr}     // unknown
+};
+
 void R2Simulator::preState(){
-  switch(env.state)
-  {
-    case R2State::Inactive: 
-      break;
-    case R2State::Ready:  // currently unused
-      break;
-    case R2State::Kickoff1:
-      env.ballCatched=0;
-      env.ball.pos.zero();
-      env.ball.velocity.zero();
-      break;
-    case R2State::Kickoff2:
-      env.ballCatched=0;
-      env.ball.pos.zero();
-      env.ball.velocity.zero();
-      break;
-    case R2State::Play:
-      if(env.ballCatched){
-        if(!isPlayerInsideHisArea(0, int(env.ballCatchedTeam2))){
-          env.ballCatched=0;  //goalkeeper exited his area, balls drop
-        }
-        else{
-          env.ballCatched--;
-        }
-        
-        if(env.ballCatched==0){
-          setBallReleasedPosition();  // position ball in front of goalkeeper
-        }
-      }
-      ballAlreadyKicked=false;
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Stopped:
-      env.ballCatched=0;
-      setBallReleasedPosition();
-      env.ball.velocity.zero();
-      break;
-    case R2State::Goalkick1up:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.goalKickLx;
-      else
-        env.ball.pos.x=pitch.goalKickRx;
-      env.ball.pos.y=pitch.goalKickUy;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Goalkick1down:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.goalKickLx;
-      else
-        env.ball.pos.x=pitch.goalKickRx; 
-      env.ball.pos.y=pitch.goalKickDy;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Goalkick2up:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.goalKickRx;
-      else
-        env.ball.pos.x=pitch.goalKickLx;
-      env.ball.pos.y=pitch.goalKickUy;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Goalkick2down:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.goalKickRx;
-      else
-        env.ball.pos.x=pitch.goalKickLx;
-      env.ball.pos.y=pitch.goalKickDy;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Corner1up:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.x1;
-      else
-        env.ball.pos.x=pitch.x2;
-      env.ball.pos.y=pitch.y1;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Corner1down:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.x1;
-      else
-        env.ball.pos.x=pitch.x2;
-      env.ball.pos.y=pitch.y2;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Corner2up:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.x2;
-      else
-        env.ball.pos.x=pitch.x1;
-      env.ball.pos.y=pitch.y1;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Corner2down:
-      env.ballCatched=0;
-      if(!env.halftimePassed) 
-        env.ball.pos.x=pitch.x2;
-      else
-        env.ball.pos.x=pitch.x1;
-      env.ball.pos.y=pitch.y2;
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Throwin1:
-      env.ballCatched=0;
-      setBallThrowInPosition();
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Throwin2:
-      env.ballCatched=0;
-      setBallThrowInPosition();
-      env.ball.velocity.zero();
-      env.startingTeamMaxRange=0.0;
-      break;
-    case R2State::Paused:
-      break;
-    case R2State::Halftime:
-      env.ballCatched=0;
-      break;
-    case R2State::Goal1:
-      break;
-    case R2State::Goal2:
-      break;
-    case R2State::Ended:
-      break;
-    default:
-      break;
-  } 
+  R2S_PROFILE_PHASE(R2Phase::PreState);
+  auto handler=stateHandlers[stateIndex(env.state)].pre;
+  if(handler)
+    (this->*handler)();
+}
+
+void R2Simulator::preKickoff(){
+  env.ballCatched=0;
+  env.ball.pos.zero();
+  env.ball.velocity.zero();
+}
+
+void R2Simulator::prePlay(){
+  if(env.ballCatched){
+    if(!isPlayerInsideHisArea(0, int(env.ballCatchedTeam2))){
+      env.ballCatched=0;  //goalkeeper exited his area, balls drop
+    }
+    else{
+      env.ballCatched--;
+    }
+    
+    if(env.ballCatched==0){
+      setBallReleasedPosition();  // position ball in front of goalkeeper
+    }
+  }
+  ballAlreadyKicked=false;
+  env.startingTeamMaxRange=0.0;
+}
+
+void R2Simulator::preStopped(){
+  env.ballCatched=0;
+  setBallReleasedPosition();
+  env.ball.velocity.zero();
+}
+
+void R2Simulator::preGoalkick(){
+  const R2StateProperties& state=stateProperties(env.state);
+  env.ballCatched=0;
+  if(state.team2 != env.halftimePassed)   // the right side
+    env.ball.pos.x=pitch.goalKickRx;
+  else
+    env.ball.pos.x=pitch.goalKickLx;
+  env.ball.pos.y= state.up ? pitch.goalKickUy : pitch.goalKickDy;
+  env.ball.velocity.zero();
+  env.startingTeamMaxRange=0.0;
+}
+
+void R2Simulator::preCorner(){
+  const R2StateProperties& state=stateProperties(env.state);
+  env.ballCatched=0;
+  if(state.team2 != env.halftimePassed)   // the right side
+    env.ball.pos.x=pitch.x2;
+  else
+    env.ball.pos.x=pitch.x1;
+  env.ball.pos.y= state.up ? pitch.y1 : pitch.y2;
+  env.ball.velocity.zero();
+  env.startingTeamMaxRange=0.0;
+}
+
+void R2Simulator::preThrowin(){
+  env.ballCatched=0;
+  setBallThrowInPosition();
+  env.ball.velocity.zero();
+  env.startingTeamMaxRange=0.0;
+}
+
+void R2Simulator::preHalftime(){
+  env.ballCatched=0;
 }
 
 void R2Simulator::checkState(){
-  switch(env.state)
-  {
-    case R2State::Inactive: 
-      break;
-    case R2State::Ready: 
-      break;
-    case R2State::Kickoff1:
-      limitPlayersToHalfPitchFullBody(0);
-      manageStaticBallCollisions();
-      manageStaticPlayersCollisions();
-      manageStaticBallCollisions();
-      limitPlayersToHalfPitchFullBody(0);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
-    case R2State::Kickoff2:
-      limitPlayersToHalfPitchFullBody(1);
-      manageStaticBallCollisions();
-      manageStaticPlayersCollisions();
-      manageStaticBallCollisions();
-      limitPlayersToHalfPitchFullBody(1);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
-    case R2State::Play:
-      updateCollisionsAndMovements();
-      break;
-    case R2State::Stopped:
-      break;
-    case R2State::Goalkick1up:
-    case R2State::Goalkick1down:
-      limitPlayersOutsideAreaFullBody(false);
-      manageStaticBallCollisions();
-      manageStaticPlayersCollisions();
-      limitPlayersOutsideAreaFullBody(false);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
-    case R2State::Goalkick2up:
-    case R2State::Goalkick2down:
-      limitPlayersOutsideAreaFullBody(true);
-      manageStaticBallCollisions();
-      manageStaticPlayersCollisions();
-      limitPlayersOutsideAreaFullBody(true);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
-    case R2State::Corner1up:
-    case R2State::Corner1down:
-      putPlayersFarFromBall(1, sett.cornerMinDistance);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
-    case R2State::Corner2up:
-    case R2State::Corner2down:
-      putPlayersFarFromBall(0, sett.cornerMinDistance);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
-    case R2State::Throwin1:
-      putPlayersFarFromBall(1, sett.throwinMinDistance);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
-    case R2State::Throwin2:
-      putPlayersFarFromBall(0, sett.throwinMinDistance);
-      oldEnv = env;
-      env.state=R2State::Play;
-      break;
+  R2S_PROFILE_PHASE(R2Phase::CheckState);
+  auto handler=stateHandlers[stateIndex(env.state)].check;
+  if(handler)
+    (this->*handler)();
+}
 
-    case R2State::Paused:
-      break;
-    case R2State::Halftime:
-      break;
-    case R2State::Goal1:
-      oldEnv = env;
-      env.state=R2State::Kickoff2;
-      break;
-    case R2State::Goal2:
-      oldEnv = env;
-      env.state=R2State::Kickoff1;
-      break;
-    case R2State::Ended:
-      break;
-    default:
-      break;
-  } 
+void R2Simulator::checkKickoff(){
+  int kickTeam= int(stateProperties(env.state).team2);
+  limitPlayersToHalfPitchFullBody(kickTeam);
+  manageStaticBallCollisions();
+  manageStaticPlayersCollisions();
+  manageStaticBallCollisions();
+  limitPlayersToHalfPitchFullBody(kickTeam);
+  oldEnv = env;
+  env.state=R2State::Play;
+}
+
+void R2Simulator::checkPlay(){
+  updateCollisionsAndMovements();
+}
+
+void R2Simulator::checkGoalkick(){
+  int kickTeam= int(stateProperties(env.state).team2);
+  limitPlayersOutsideAreaFullBody(kickTeam);
+  manageStaticBallCollisions();
+  manageStaticPlayersCollisions();
+  limitPlayersOutsideAreaFullBody(kickTeam);
+  oldEnv = env;
+  env.state=R2State::Play;
+}
+
+void R2Simulator::checkCorner(){
+  int otherTeam= stateProperties(env.state).team2 ? 0 : 1;
+  putPlayersFarFromBall(otherTeam, sett.cornerMinDistance);
+  oldEnv = env;
+  env.state=R2State::Play;
+}
+
+void R2Simulator::checkThrowin(){
+  int otherTeam= stateProperties(env.state).team2 ? 0 : 1;
+  putPlayersFarFromBall(otherTeam, sett.throwinMinDistance);
+  oldEnv = env;
+  env.state=R2State::Play;
+}
+
+// the team that did not score kicks off
+void R2Simulator::checkGoal(){
+  oldEnv = env;
+  env.state= (env.state==R2State::Goal1) ? R2State::Kickoff2 : R2State::Kickoff1;
+}
+
+void R2Simulator::reset(unsigned int _random_seed) {
+  random_seed=_random_seed;
+  rng.seed(_random_seed);
+  normalDist.reset();
+  uniformDist.reset();
+  counterRng.setSeed(_random_seed);
+  std::fill(randomDraws.begin(), randomDraws.end(), 0);
+
+  env.reset();
+  oldEnv.reset();
+  std::iota (std::begin(shuffledPlayers), std::end(shuffledPlayers), 0);
+  startedTeam2=false;
+  ballAlreadyKicked=false;
+  processedActions=0;  // history is overwritten from the start, env.tick being its cursor
+  events=R2Events();
+  physics=R2PhysicsCounters();
+  for(int t=0; t<=1; t++){
+    for(auto& l : agentLatency[t])
+      l.clear();
+    teamLatency[t].clear();
+  }
+  std::fill(givenActions.begin(), givenActions.end(), false);
+  std::fill(stateHashes.begin(), stateHashes.end(), 0);
+  stateDigest=0;
+  if(observationLatency)
+    startPipeline();  // also waits for the decisions still running, before the agents are reset
+  for(int t=0; t<=1; t++)
+    for(auto& agent : teams[t])
+      agent->reset();
+}
+
+void R2Simulator::reset(unsigned int _random_seed, const R2EnvSettings& _settings) {
+  sett=_settings;
+  pitch=R2Pitch(sett.pitchWidth, sett.pitchLength, sett.goalWidth, sett.netLength, sett.poleRadius, sett.outPitchLimit);
+  cosKickableAngle=cos(sett.kickableAngle);
+  cosCatchableAngle=cos(sett.catchableAngle);
+
+  // storage is reallocated only if the length of the match changed
+  int ticks=sett.ticksPerTime*2;
+  if(historyEnabled && (int(history.actions.size()) != ticks)){
+    history.envs.resize(ticks+1);
+    history.actions.resize(ticks, std::vector<R2ActionRecord>(shuffledPlayers.size()));
+  }
+  if(stateHashing)
+    stateHashes.resize(ticks+1);
+
+  reset(_random_seed);
+}
+
+void R2Simulator::setHistoryEnabled(bool enabled) {
+  if(enabled == historyEnabled)
+    return;
+  historyEnabled=enabled;
+  if(enabled){
+    history=R2History(sett.ticksPerTime*2, env.teams[0].size(), env.teams[1].size());
+  }
+  else{ // release the memory
+    history.envs=std::vector<R2Environment>();
+    history.actions=std::vector<std::vector<R2ActionRecord>>();
+  }
+}
+
+void R2Simulator::setStateHashing(bool enabled) {
+  if(enabled == stateHashing)
+    return;
+  stateHashing=enabled;
+  if(enabled)
+    stateHashes.assign(sett.ticksPerTime*2+1, 0);
+  else  // release the memory
+    stateHashes=std::vector<uint64_t>();
 }
 
 void R2Simulator::setStartMatch() {
   startedTeam2=false;
-  if(uniformDist(rng) >= 0.5)
+  if(randomUniform(R2RandomPurpose::StartMatch) >= 0.5)
     startedTeam2=true;
   env.state= startedTeam2 ? R2State::Kickoff2 : R2State::Kickoff1;
 }
@@ -1997,7 +2701,8 @@ bool R2Simulator::stepIfPlaying(){
     return true;
   }
   else if(env.tick==(sett.ticksPerTime*2)){
-      history.envs.back()=env;  // log also final environment
+      if(historyEnabled)
+        history.envs.back()=env;  // log also final environment
       env.tick++;
       env.state=R2State::Ended;
 	}
@@ -2007,65 +2712,47 @@ bool R2Simulator::stepIfPlaying(){
   return false;
 }
 
+R2Events R2Simulator::stepN(int k, const std::vector<R2Action>& actions, const std::vector<bool>& given){
+  struct GivenActionsGuard {  // the agents are asked again after stepN(), also if it is left by an exception
+    std::vector<bool>& flags;
+    ~GivenActionsGuard(){ std::fill(flags.begin(), flags.end(), false); }
+  } givenActionsGuard{givenActions};
+
+  R2Events before=events;
+  int n=givenActions.size();
+  for(int i=0; (i<n) && (i<int(actions.size())); i++){
+    givenActions[i]= given.empty() ? true : ((i<int(given.size())) && given[i]);
+    givenActionsValues[i]=actions[i];
+  }
+
+  int ticks=0;
+  while( (ticks<k) && stepIfPlaying() )
+    ticks++;
+
+  R2Events happened=events-before;
+  happened.ticks=ticks;
+  return happened;
+}
+
 void R2Simulator::processStep(const R2Action& action, int team, int player){
-  history.actions[env.tick][processedActions].team=team;
-  history.actions[env.tick][processedActions].action=action;
-  history.actions[env.tick][processedActions].player=player;
+  R2S_PROFILE_PHASE(R2Phase::PlayersProcessStep);
+  if(historyEnabled){
+    history.actions[env.tick][processedActions].team=team;
+    history.actions[env.tick][processedActions].action=action;
+    history.actions[env.tick][processedActions].player=player;
+  }
   processedActions++;
  
-  switch(env.state)
-  {
-    case R2State::Inactive: 
-      break;
-    case R2State::Ready:  // currently, an unnecessary state
-      procReady(action, team, player); 
-      break;
-    case R2State::Kickoff1:
-    case R2State::Kickoff2:
-      procKickoff(action, team, player);
-      break;
-    case R2State::Play:
-      procPlay(action, team, player);
-      break;
-    case R2State::Stopped:
-      break;
-    case R2State::Goalkick1up:
-    case R2State::Goalkick1down:
-    case R2State::Goalkick2up:
-    case R2State::Goalkick2down:
-      procGoalkick(action, team, player);
-      break;
-    case R2State::Corner1up:
-    case R2State::Corner1down:
-    case R2State::Corner2up:
-    case R2State::Corner2down:
-      procCorner(action, team, player);
-      break;
-    case R2State::Throwin1:
-    case R2State::Throwin2:
-      procThrowin(action, team, player);
-      break;
-    case R2State::Paused:
-      break;
-    case R2State::Halftime:
-      break;
-    case R2State::Goal1:
-    case R2State::Goal2:
-      procGoal(action, team, player);
-      break;
-    case R2State::Ended:
-      procEnded(action, team, player);
-      break;
-    default:
-      break;
-  } 
+  auto handler=stateHandlers[stateIndex(env.state)].process;
+  if(handler)
+    (this->*handler)(action, team, player);
 }
 
 // we check the center of the body of the player
 void R2Simulator::limitPlayersOutsideArea(int kickTeam){
   int i=0;
   int team=1-kickTeam;
-  double defaultX= ((kickTeam && (!env.halftimePassed) ) || ( (!kickTeam) && env.halftimePassed) ) ? pitch.areaRx : pitch.areaLx;
+  R2Scalar defaultX= ((kickTeam && (!env.halftimePassed) ) || ( (!kickTeam) && env.halftimePassed) ) ? pitch.areaRx : pitch.areaLx;
   for(auto& p: env.teams[team]){
     if(isPlayerInsideOpponentArea(i, team)){
       p.pos.x=defaultX;
@@ -2077,7 +2764,7 @@ void R2Simulator::limitPlayersOutsideArea(int kickTeam){
 void R2Simulator::limitPlayersOutsideAreaFullBody(int kickTeam){
   int i=0;
   int team=1-kickTeam;
-  double defaultX= ((kickTeam && (!env.halftimePassed) ) || ( (!kickTeam) && env.halftimePassed) )? (pitch.areaRx-sett.playerRadius) : (pitch.areaLx+sett.playerRadius);
+  R2Scalar defaultX= ((kickTeam && (!env.halftimePassed) ) || ( (!kickTeam) && env.halftimePassed) )? (pitch.areaRx-sett.playerRadius) : (pitch.areaLx+sett.playerRadius);
   for(auto& p: env.teams[team]){
     if(isPlayerInsideOpponentAreaFullBody(i, team)){
       p.pos.x=defaultX;
@@ -2087,7 +2774,7 @@ void R2Simulator::limitPlayersOutsideAreaFullBody(int kickTeam){
 }
 
 // we check the complete diameter of the body of the player
-void R2Simulator::limitPlayersToHalfPitch(int kickTeam, double dueDistance){
+void R2Simulator::limitPlayersToHalfPitch(int kickTeam, R2Scalar dueDistance){
   for(auto& p: env.teams[0]){
     if (!env.halftimePassed){
       if (p.pos.x >0.0)
@@ -2111,14 +2798,14 @@ void R2Simulator::limitPlayersToHalfPitch(int kickTeam, double dueDistance){
   }
   
   for(auto& p: env.teams[1-kickTeam]){
-    double dist=p.absDistanceFromCenter();
+    R2Scalar dist=p.absDistanceFromCenter();
     if(dist<=R2Epsilon){
       p.pos.x=(-2*kickTeam+1)*dueDistance;  //to have sign - only if kickteam is 1
-      p.pos.y=(uniformDist(rng)-0.5)*dueDistance;
+      p.pos.y=(randomUniform(R2RandomPurpose::HalfPitchPosition, 1-kickTeam, int(&p - env.teams[1-kickTeam].data()))-0.5)*dueDistance;
     }
     else if (dist < dueDistance)
     {
-      double ratio=dueDistance/dist;
+      R2Scalar ratio=dueDistance/dist;
       p.pos.x*=ratio;
       p.pos.y*=ratio;
     }
@@ -2290,54 +2977,39 @@ std::vector<std::string> R2Simulator::getTeamNames(){
   return std::vector<std::string>{ teamNames[0], teamNames[1]};
 }
 
-std::string R2Simulator::getStateString(){
-  std::string s= teamNames[0]+(env.halftimePassed ? " (right) " : " (left) ")+ "vs " + teamNames[1]+(env.halftimePassed ? " (left) " : " (right) ")+ to_string(env.score1)+"-"+to_string(env.score2)+" "+"tick:"+to_string(env.tick)+" ";
-  switch(env.state)  {
-    case R2State::Inactive: 
-      return s+string("Inactive");
-    case R2State::Ready:  // currently, an unnecessary state
-      return s+string("Ready");
-    case R2State::Kickoff1:
-      return s+string("Kickoff1");
-    case R2State::Kickoff2:
-      return s+string("Kickoff2");
-    case R2State::Play:
-      return s+string("Play");
-    case R2State::Stopped:
-      return s+string("Stopped");
-    case R2State::Goalkick1up:
-      return s+string("Goalkick1up");
-    case R2State::Goalkick1down:
-      return s+string("Goalkick1down");
-    case R2State::Goalkick2up:
-      return s+string("Goalkick2up");
-    case R2State::Goalkick2down:
-      return s+string("Goalkick2down");
-    case R2State::Corner1up:
-      return s+string("Corner1up");
-    case R2State::Corner1down:
-      return s+string("Corner1down");
-    case R2State::Corner2up:
-      return s+string("Corner2up");
-    case R2State::Corner2down:
-      return s+string("Corner2down");
-    case R2State::Throwin1:
-      return s+string("Throwin1");
-    case R2State::Throwin2:
-      return s+string("Throwin2");
-    case R2State::Paused:
-      return s+string("Paused");
-    case R2State::Halftime:
-      return s+string("Halftime");
-    case R2State::Goal1:
-      return s+string("Goal1");
-    case R2State::Goal2:
-      return s+string("Goal2");
-    case R2State::Ended:
-      return s+string("Ended");
-    default:
-      return s+string("Unknown");
+// report of agents decision times, in microseconds
+std::string R2Simulator::getAgentLatencyString(){
+  auto describe=[](const R2AgentLatency& l){
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "steps:%llu total:%.1f mean:%.2f p99:%.2f max:%.2f overruns:%llu", (unsigned long long)l.latency.count,
+      double(l.latency.sum)*1e-3, l.latency.mean()*1e-3, double(l.latency.percentile(0.99))*1e-3, double(l.latency.max)*1e-3, (unsigned long long)l.overruns);
+    return std::string(buffer);
+  };
+
+  std::string s="agents latency (microseconds)\n";
+  for(int t=0; t<=1; t++){
+    s+= teamNames[t] + " " + describe(teamLatency[t]) + "\n";
+    for(int i=0; i<int(agentLatency[t].size()); i++)
+      s+= "  player " + to_string(i) + " " + describe(agentLatency[t][i]) + "\n";
   }
+  return s;
+}
+
+std::string R2Simulator::getStateString(){
+  std::string s;
+  s.reserve(teamNames[0].size()+teamNames[1].size()+64);
+  s+= teamNames[0];
+  s+= env.halftimePassed ? " (right) vs " : " (left) vs ";
+  s+= teamNames[1];
+  s+= env.halftimePassed ? " (left) " : " (right) ";
+  s+= to_string(env.score1);
+  s+= '-';
+  s+= to_string(env.score2);
+  s+= " tick:";
+  s+= to_string(env.tick);
+  s+= ' ';
+  s+= stateProperties(env.state).name;
+  return s;
 }
  
 std::string R2Simulator::createDateFilename(){
@@ -2432,6 +3104,70 @@ bool R2Simulator::saveStatesHistory(std::string filename){
   return true;
 }
 
+int R2Simulator::getHistoryStatesLength(){
+  return std::min(std::max(env.tick, 0), int(history.envs.size()));
+}
+
+int R2Simulator::getHistoryActionsLength(){
+  return std::min(std::max(env.tick, 0), int(history.actions.size()));
+}
+
+bool R2Simulator::savePhysicsCounters(std::string filename){
+  ofstream myfile;
+  myfile.open (filename);
+  if (!myfile.is_open())
+    return false;
+
+  myfile << R2SVersion << std::endl;
+
+  myfile << "sub_steps";
+  for(int n : physics.subSteps)
+    myfile << "," << n;
+  myfile << std::endl;
+
+  myfile << "collisions_pole_ball," << physics.collisions[int(R2CollisionType::PoleBall)] << std::endl;
+  myfile << "collisions_pole_player," << physics.collisions[int(R2CollisionType::PolePlayer)] << std::endl;
+  myfile << "collisions_ball_player," << physics.collisions[int(R2CollisionType::BallPlayer)] << std::endl;
+  myfile << "collisions_player_player," << physics.collisions[int(R2CollisionType::PlayerPlayer)] << std::endl;
+  myfile << "cap_hits_collisions_loop," << physics.collisionsLoopCapHits << std::endl;
+  myfile << "cap_hits_ball_inside_players," << physics.ballInsidePlayersCapHits << std::endl;
+  myfile << "cap_hits_static_ball," << physics.staticBallCapHits << std::endl;
+  myfile << "cap_hits_static_players," << physics.staticPlayersCapHits << std::endl;
+  myfile << "cap_hits_static_pole_players," << physics.staticPolePlayersCapHits << std::endl;
+  myfile << "anti_bounces," << physics.antiBounces << std::endl;
+  myfile << "ball_player_blacklists," << physics.ballPlayerBlacklists << std::endl;
+  myfile << "activations_ball_inside_players," << physics.ballInsidePlayersActivations << std::endl;
+  myfile << "activations_static_ball," << physics.staticBallActivations << std::endl;
+  myfile << "activations_static_players," << physics.staticPlayersActivations << std::endl;
+  myfile << "activations_static_pole_players," << physics.staticPolePlayersActivations << std::endl;
+  myfile << "tolerance_stops_static_players," << physics.staticPlayersToleranceStops << std::endl;
+  myfile << "quiet_ticks," << physics.quietTicks << std::endl;
+
+  myfile.close();
+  return true;
+}
+
+bool R2Simulator::saveStateHashes(std::string filename){
+  if(!stateHashing)   // a file with no hashes would make any two matches look the same
+    return false;
+  ofstream myfile;
+  myfile.open (filename);
+  if (!myfile.is_open())
+    return false;
+
+  myfile << R2SVersion << std::endl;
+  char line[64];
+  snprintf(line, sizeof(line), "digest,%016llx", (unsigned long long)stateDigest);
+  myfile << line << std::endl;
+  for(int tick=1; (tick<=env.tick) && (tick<int(stateHashes.size())); tick++){
+    snprintf(line, sizeof(line), "%d,%016llx", tick, (unsigned long long)stateHashes[tick]);
+    myfile << line << std::endl;
+  }
+
+  myfile.close();
+  return true;
+}
+
 bool R2Simulator::saveActionsHistory(std::string filename){
   ofstream myfile;
   myfile.open (filename);
@@ -2449,6 +3185,158 @@ bool R2Simulator::saveActionsHistory(std::string filename){
 }
 
 
+// each line is either "S" followed by the settings, that stay valid for the following lines, or "E" followed by team, player and environment
+bool saveStateSamples(std::string filename, const std::vector<R2StateSample>& samples){
+  ofstream myfile;
+  myfile.open (filename);
+  if (!myfile.is_open())
+    return false;
+
+  myfile.precision(17);
+  myfile << R2SVersion << std::endl;
+
+  const R2EnvSettings* lastSettings=nullptr;
+  for(auto& sample : samples){
+    const R2EnvSettings& sett=sample.state.sett;
+    if((lastSettings==nullptr) || memcmp(lastSettings, &sett, sizeof(R2EnvSettings))){  // (a difference in padding bytes would only add a redundant line)
+      myfile << "S," << sett.simplified << "," << sett.ticksPerTime << "," << sett.pitchLength << "," << sett.pitchWidth << "," << sett.goalWidth
+        << "," << sett.centerRadius << "," << sett.poleRadius << "," << sett.ballRadius << "," << sett.playerRadius << "," << sett.catchRadius
+        << "," << sett.catchHoldingTicks << "," << sett.kickRadius << "," << sett.kickableDistance << "," << sett.catchableDistance
+        << "," << sett.kickableAngle << "," << sett.kickableDirectionAngle << "," << sett.catchableAngle << "," << sett.netLength
+        << "," << sett.catchableAreaLength << "," << sett.catchableAreaWidth << "," << sett.cornerMinDistance << "," << sett.throwinMinDistance
+        << "," << sett.outPitchLimit << "," << sett.maxDashPower << "," << sett.maxKickPower << "," << sett.playerVelocityDecay
+        << "," << sett.ballVelocityDecay << "," << sett.maxPlayerSpeed << "," << sett.maxBallSpeed << "," << sett.catchProbability
+        << "," << sett.playerRandomNoise << "," << sett.playerDirectionNoise << "," << sett.playerVelocityDirectionMix
+        << "," << sett.ballInsidePlayerVelocityDisplace << "," << sett.afterCatchDistance << std::endl;
+      lastSettings=&sett;
+    }
+
+    const R2Environment& env=sample.state.env;
+    myfile << "E," << sample.team << "," << sample.player << "," << env.tick << "," << env.score1 << "," << env.score2 << "," << int(env.state) << ",";
+    myfile << env.ball.pos.x << "," << env.ball.pos.y << "," << env.ball.velocity.x << "," << env.ball.velocity.y << ",";
+    myfile << env.teams[0].size() << "," << env.teams[1].size();
+    for(int t=0; t<=1; t++)
+      for(auto& p: env.teams[t])
+        myfile << "," << p.pos.x << "," << p.pos.y << "," << p.velocity.x << "," << p.velocity.y << "," << p.direction << "," << p.acted;
+    myfile << "," << env.lastTouchedTeam2 << "," << env.startingTeamMaxRange << "," << env.ballCatched << "," << env.ballCatchedTeam2 << "," << env.halftimePassed;
+    myfile << std::endl;
+  }
+
+  myfile.close();
+  return true;
+}
+
+// multiply-rotate mixing of 64 bit words (as in xxHash). Objects are spread on 4 independent lanes, that the cpu can process in parallel.
+static inline uint64_t hashWord(uint64_t h, uint64_t w){
+  h^= w*0x9E3779B97F4A7C15ULL;
+  h= (h<<31 | h>>33)*0xC2B2AE3D27D4EB4FULL;
+  return h;
+}
+
+static inline uint64_t hashWord(uint64_t h, double d){   // single precision values are hashed exactly as their double conversion
+  uint64_t w;
+  memcpy(&w, &d, sizeof(w));
+  return hashWord(h, w);
+}
+
+static inline uint64_t rotl(uint64_t x, int r){
+  return (x<<r) | (x>>(64-r));
+}
+
+uint64_t hashEnvironment(const R2Environment& env){
+  uint64_t a=0x27D4EB2F165667C5ULL, b=0x165667B19E3779F9ULL, c=0x85EBCA77C2B2AE63ULL, d=0x61C8864E7A143579ULL;
+  a=hashWord(a, uint64_t(uint32_t(env.tick)) | (uint64_t(uint32_t(env.score1))<<32));
+  b=hashWord(b, uint64_t(uint32_t(env.score2)) | (uint64_t(uint32_t(env.state))<<32));
+  c=hashWord(c, env.startingTeamMaxRange);
+  d=hashWord(d, uint64_t(uint32_t(env.ballCatched)) | (uint64_t(env.lastTouchedTeam2)<<32) | (uint64_t(env.ballCatchedTeam2)<<33) | (uint64_t(env.halftimePassed)<<34)
+    | (uint64_t(env.teams[0].size())<<40) | (uint64_t(env.teams[1].size())<<52));
+  a=hashWord(a, env.ball.pos.x);
+  b=hashWord(b, env.ball.pos.y);
+  c=hashWord(c, env.ball.velocity.x);
+  d=hashWord(d, env.ball.velocity.y);
+  for(int w=0; w<=1; w++)
+    for(auto& p : env.teams[w]){
+      a=hashWord(a, p.pos.x);
+      b=hashWord(b, p.pos.y);
+      c=hashWord(c, p.velocity.x);
+      d=hashWord(d, p.velocity.y);
+      a=hashWord(a, p.direction);
+      b=hashWord(b, uint64_t(p.acted));
+    }
+  uint64_t h=rotl(a, 1) + rotl(b, 7) + rotl(c, 12) + rotl(d, 18);
+  h^= h>>33;
+  h*= 0xFF51AFD7ED558CCDULL;
+  h^= h>>33;
+  h*= 0xC4CEB9FE1A85EC53ULL;
+  h^= h>>33;
+  return h;
+}
+
+// returns the samples read before the first malformed line, if any
+std::vector<R2StateSample> loadStateSamples(std::string filename){
+  std::vector<R2StateSample> samples;
+  ifstream myfile;
+  myfile.open (filename);
+  if (!myfile.is_open())
+    return samples;
+
+  std::string line;
+  if(!std::getline(myfile, line)) // version
+    return samples;
+
+  R2EnvSettings sett;
+  bool settingsRead=false;
+  while(std::getline(myfile, line)){
+    if(line.empty())
+      continue;
+    std::vector<R2Scalar> v;
+    const char* p=line.c_str()+1;
+    while(*p==','){
+      char* end;
+      v.push_back(strtod(p+1, &end));
+      p=end;
+    }
+
+    if((line[0]=='S') && (v.size()==35)){
+      int i=0;
+      sett.simplified=bool(v[i++]); sett.ticksPerTime=int(v[i++]); sett.pitchLength=v[i++]; sett.pitchWidth=v[i++]; sett.goalWidth=v[i++];
+      sett.centerRadius=v[i++]; sett.poleRadius=v[i++]; sett.ballRadius=v[i++]; sett.playerRadius=v[i++]; sett.catchRadius=v[i++];
+      sett.catchHoldingTicks=int(v[i++]); sett.kickRadius=v[i++]; sett.kickableDistance=v[i++]; sett.catchableDistance=v[i++];
+      sett.kickableAngle=v[i++]; sett.kickableDirectionAngle=v[i++]; sett.catchableAngle=v[i++]; sett.netLength=v[i++];
+      sett.catchableAreaLength=v[i++]; sett.catchableAreaWidth=v[i++]; sett.cornerMinDistance=v[i++]; sett.throwinMinDistance=v[i++];
+      sett.outPitchLimit=v[i++]; sett.maxDashPower=v[i++]; sett.maxKickPower=v[i++]; sett.playerVelocityDecay=v[i++];
+      sett.ballVelocityDecay=v[i++]; sett.maxPlayerSpeed=v[i++]; sett.maxBallSpeed=v[i++]; sett.catchProbability=v[i++];
+      sett.playerRandomNoise=v[i++]; sett.playerDirectionNoise=v[i++]; sett.playerVelocityDirectionMix=v[i++];
+      sett.ballInsidePlayerVelocityDisplace=v[i++]; sett.afterCatchDistance=v[i++];
+      settingsRead=true;
+    }
+    else if((line[0]=='E') && settingsRead && (v.size()>=12)){
+      int n1=int(v[10]), n2=int(v[11]);
+      if((n1<0) || (n2<0) || (v.size() != size_t(12+(n1+n2)*6+5)))
+        break;
+      R2Environment env(n1, n2);
+      env.tick=int(v[2]); env.score1=int(v[3]); env.score2=int(v[4]); env.state=R2State(int(v[5]));
+      env.ball=R2ObjectInfo(v[6], v[7], v[8], v[9]);
+      int i=12;
+      for(int t=0; t<=1; t++)
+        for(auto& pl: env.teams[t]){
+          pl=R2PlayerInfo(v[i], v[i+1], v[i+2], v[i+3], v[i+4]);
+          pl.acted=bool(v[i+5]);
+          i+=6;
+        }
+      env.lastTouchedTeam2=bool(v[i]); env.startingTeamMaxRange=v[i+1]; env.ballCatched=int(v[i+2]);
+      env.ballCatchedTeam2=bool(v[i+3]); env.halftimePassed=bool(v[i+4]);
+      R2Pitch pitch(sett.pitchWidth, sett.pitchLength, sett.goalWidth, sett.netLength, sett.poleRadius, sett.outPitchLimit);
+      samples.push_back(R2StateSample(int(v[0]), int(v[1]), R2GameState(sett, env, pitch)));
+    }
+    else
+      break;
+  }
+
+  myfile.close();
+  return samples;
+}
+
 void R2Simulator::setEnvironment(int _tick, int _score1, int _score2, R2State _state, R2ObjectInfo _ball, 
     std::vector<R2PlayerInfo> _team1, std::vector<R2PlayerInfo> _team2,
     bool _lastTouchedTeam2, int _ballCatched, bool _ballCatchedTeam2) {
@@ -2460,8 +3348,8 @@ void R2Simulator::setEnvironment(int _tick, int _score1, int _score2, R2State _s
         env.score2=_score2;
         env.state=_state;
         env.ball=_ball;
-        env.teams[0]=_team1;
-        env.teams[1]=_team2;
+        env.teams[0].assign(_team1.begin(), _team1.end());
+        env.teams[1].assign(_team2.begin(), _team2.end());
         env.lastTouchedTeam2=_lastTouchedTeam2;
         env.ballCatched=_ballCatched;
         env.ballCatchedTeam2=_ballCatchedTeam2;
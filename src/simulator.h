@@ -4,6 +4,11 @@
 #define R2S_SIMULATOR_H
 
 #include "vec2.h"
+#include "profiler.h"
+#include "random.h"
+#include "thread_pool.h"
+#include "impact_kernel.h"
+#include "small_vector.h"
 
 #ifdef _WIN32
     #include  <numeric>
@@ -19,8 +24,9 @@
 #include <vector>
 #include <random>
 #include <array>
-#include <set>
+#include <algorithm>
 #include <limits>
+#include <type_traits>
 #include <chrono>
 
 #define _USE_MATH_DEFINES
@@ -45,9 +51,10 @@ constexpr auto defaultTeam1Name = "Team A";
 constexpr auto defaultTeam2Name = "Team B";
 
 constexpr double ContemporaryKickProbability=0.5;
-constexpr double R2SmallEpsilon=std::numeric_limits<double>::epsilon();
-constexpr double R2Epsilon=std::numeric_limits<double>::epsilon() * 10.0;
-constexpr double R2BigEpsilon=std::numeric_limits<double>::epsilon() * 100.0;
+constexpr R2Scalar R2SmallEpsilon=std::numeric_limits<R2Scalar>::epsilon();
+constexpr R2Scalar R2Epsilon=std::numeric_limits<R2Scalar>::epsilon() * 10.0;
+constexpr R2Scalar R2BigEpsilon=std::numeric_limits<R2Scalar>::epsilon() * 100.0;
+constexpr bool R2SinglePrecision=std::is_same<R2Scalar, float>::value;   // see R2Scalar in vec2.h
 
 constexpr double BallPlayerHitFactor=1.1;   //to avoid ball having exactly the same speed 
 constexpr double BallPlayerHitFactorSimplified=1.001;   //to avoid ball having exactly the same speed (use 0.0 to have it completely stopped)
@@ -103,30 +110,36 @@ constexpr double MinimumCornerDistance=2.5; // this is typical for 5-a-side socc
 constexpr double MinimumThrowinDistance=2.5; // this is typical for 5-a-side soccer = 4.0
 constexpr int   MaxCollisionLoop=10;    // 10
 constexpr int   MaxCollisionInsideTickLoop=40;  //40
+constexpr int   ParallelCollisionsMinPlayers=64;    // default number of players (both teams) from which the collision search may run in parallel
+constexpr int   ParallelCollisionsChunksPerThread=4;    // the candidate pairs are split in this many chunks per thread, to balance the load
+constexpr R2Scalar QuietReachFactor=4.0;  // times the displacement of a tick that an object may reach, for the quiescence test (see R2Simulator::possibleCollisions())
+constexpr R2Scalar QuietReachMargin=R2SinglePrecision ? 1e-3 : 1e-6; // added to that reach, to cover the rounding errors of the time of impact search
+constexpr double StaticFarMargin=R2SinglePrecision ? 1e-5 : 1e-9;  // relative, pairs whose squared distance exceeds the squared contact distance by this are not overlapping
+constexpr double StaticTolerance=R2SinglePrecision ? 1e-5 : 1e-9;  // default of setStaticRelaxation(), overlaps left by rounding errors after a separation are below it
 constexpr double PlayerOutOfPitchLimit=3.0;
 
-inline double calcAreaLength(double pitchLength) { return pitchLength/RegularPitchLength*RegularAreaLength; }
-inline double calcAreaWidth(double pitchWidth) { return pitchWidth/RegularPitchWidth*RegularAreaWidth; }
-inline double calcCornerDistance(double pitchWidth) { double d=pitchWidth/RegularPitchWidth*RegularCornerDistance; return (d<MinimumCornerDistance)? MinimumCornerDistance : d; }
+inline R2Scalar calcAreaLength(R2Scalar pitchLength) { return pitchLength/RegularPitchLength*RegularAreaLength; }
+inline R2Scalar calcAreaWidth(R2Scalar pitchWidth) { return pitchWidth/RegularPitchWidth*RegularAreaWidth; }
+inline R2Scalar calcCornerDistance(R2Scalar pitchWidth) { R2Scalar d=pitchWidth/RegularPitchWidth*RegularCornerDistance; return (d<MinimumCornerDistance)? MinimumCornerDistance : d; }
 
 inline unsigned int createChronoRandomSeed(){ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count(); } 
 
 //sets angle between 0 and 2 PI
-double fixAnglePositive(double angle);
+R2Scalar fixAnglePositive(R2Scalar angle);
 //sets angle between + and - PI
-double fixAngleTwoSides(double angle);
+R2Scalar fixAngleTwoSides(R2Scalar angle);
 
 struct R2Pitch {
-    double x1,x2,y1,y2;
-    double xGoal1, xGoal2;
-    double yGoal1, yGoal2;
-    double areaLx, areaRx, areaUy, areaDy;
-    double goalKickLx, goalKickRx, goalKickUy, goalKickDy;
+    R2Scalar x1,x2,y1,y2;
+    R2Scalar xGoal1, xGoal2;
+    R2Scalar yGoal1, yGoal2;
+    R2Scalar areaLx, areaRx, areaUy, areaDy;
+    R2Scalar goalKickLx, goalKickRx, goalKickUy, goalKickDy;
     Vec2 poles[4];
-    double border_up, border_down, border_left, border_right;
+    R2Scalar border_up, border_down, border_left, border_right;
 
-    R2Pitch(double _pitchWidth=RegularPitchWidth, double _pitchLength=RegularPitchLength, double _goalWidth=RegularGoalWidth,
-     double _netLength=0.0, double _poleRadius=PoleRadius, double _borderLimit=PlayerOutOfPitchLimit):
+    R2Pitch(R2Scalar _pitchWidth=RegularPitchWidth, R2Scalar _pitchLength=RegularPitchLength, R2Scalar _goalWidth=RegularGoalWidth,
+     R2Scalar _netLength=0.0, R2Scalar _poleRadius=PoleRadius, R2Scalar _borderLimit=PlayerOutOfPitchLimit):
         x1(_pitchLength/2.0), x2(-x1),
         y1(_pitchWidth/2.0), y2(-y1), 
         xGoal1(x1+_netLength), xGoal2( -xGoal1 ),
@@ -145,48 +158,48 @@ struct R2Pitch {
 struct R2EnvSettings {
     bool simplified;
     int ticksPerTime;
-    double pitchLength;
-    double pitchWidth;
-    double goalWidth;
-    double centerRadius;
-    double poleRadius;   
-    double ballRadius;
-    double playerRadius;
-    double catchRadius;
+    R2Scalar pitchLength;
+    R2Scalar pitchWidth;
+    R2Scalar goalWidth;
+    R2Scalar centerRadius;
+    R2Scalar poleRadius;   
+    R2Scalar ballRadius;
+    R2Scalar playerRadius;
+    R2Scalar catchRadius;
     int catchHoldingTicks;
-    double kickRadius;
-    double kickableDistance;
-    double catchableDistance;
-    double kickableAngle;
-    double kickableDirectionAngle;
-    double catchableAngle;
-    double netLength;
-    double catchableAreaLength;
-    double catchableAreaWidth;
-    double cornerMinDistance;
-    double throwinMinDistance;
-    double outPitchLimit;
-    double maxDashPower;
-    double maxKickPower;
-    double playerVelocityDecay;
-    double ballVelocityDecay;
-    double maxPlayerSpeed;
-    double maxBallSpeed;
-    double catchProbability;
-    double playerRandomNoise;
-    double playerDirectionNoise;
-    double playerVelocityDirectionMix;
-    double ballInsidePlayerVelocityDisplace;
-    double afterCatchDistance;
+    R2Scalar kickRadius;
+    R2Scalar kickableDistance;
+    R2Scalar catchableDistance;
+    R2Scalar kickableAngle;
+    R2Scalar kickableDirectionAngle;
+    R2Scalar catchableAngle;
+    R2Scalar netLength;
+    R2Scalar catchableAreaLength;
+    R2Scalar catchableAreaWidth;
+    R2Scalar cornerMinDistance;
+    R2Scalar throwinMinDistance;
+    R2Scalar outPitchLimit;
+    R2Scalar maxDashPower;
+    R2Scalar maxKickPower;
+    R2Scalar playerVelocityDecay;
+    R2Scalar ballVelocityDecay;
+    R2Scalar maxPlayerSpeed;
+    R2Scalar maxBallSpeed;
+    R2Scalar catchProbability;
+    R2Scalar playerRandomNoise;
+    R2Scalar playerDirectionNoise;
+    R2Scalar playerVelocityDirectionMix;
+    R2Scalar ballInsidePlayerVelocityDisplace;
+    R2Scalar afterCatchDistance;
 
     /**
         with 11 players: 105x68 with 7.32 mts goal, area 16,5x40,32, central circle 9,15m
         with 5 players: 40x24 with 4 mts goal, center circle 3m radius, area (proportion) 
         with 4 players: 32x19.2 with 4 mts goal, center circle 2,4m radius
     */
-    R2EnvSettings(bool _simplified=true, double _pitchLength=32, double _pitchWidth=19.2, double _goalWidth=4.0, double _centerRadius=2.4,
-    int _ticksPerTime=3000, double _poleRadius=PoleRadius,  double _ballRadius=BallRadius, double _playerRadius=PlayerRadius, double _catchRadius=CatchRadius, double _kickRadius=KickRadius,
-    double _kickableAngle=KickableAngle, double _kickableDirectionAngle=KickableDirectionAngle, double _catchableAngle=CatchableAngle,  double _netLength=1.5) :
+    R2EnvSettings(bool _simplified=true, R2Scalar _pitchLength=32, R2Scalar _pitchWidth=19.2, R2Scalar _goalWidth=4.0, R2Scalar _centerRadius=2.4,
+    int _ticksPerTime=3000, R2Scalar _poleRadius=PoleRadius,  R2Scalar _ballRadius=BallRadius, R2Scalar _playerRadius=PlayerRadius, R2Scalar _catchRadius=CatchRadius, R2Scalar _kickRadius=KickRadius,
+    R2Scalar _kickableAngle=KickableAngle, R2Scalar _kickableDirectionAngle=KickableDirectionAngle, R2Scalar _catchableAngle=CatchableAngle,  R2Scalar _netLength=1.5) :
         simplified(_simplified), ticksPerTime(_ticksPerTime), pitchLength(_pitchLength), pitchWidth(_pitchWidth), goalWidth(_goalWidth), 
         centerRadius(_centerRadius), poleRadius(_poleRadius), ballRadius(_ballRadius), playerRadius(_playerRadius), catchRadius(_catchRadius), catchHoldingTicks(CatchHoldingTicks),
         kickRadius(_kickRadius), kickableDistance(kickRadius+playerRadius+ballRadius), catchableDistance(catchRadius+playerRadius+ballRadius),
@@ -224,52 +237,87 @@ enum class R2State {
     Ended     //!< end of the match
 };
 
+// properties of the states, indexed by R2State, followed by the entry of the values out of the enumeration
+struct R2StateProperties {
+    const char* name;
+    bool starter;   // a team restarts the game: kickoff, goal-kick, corner or throw-in
+    bool team2;     // the starter is the second team
+    bool up;        // goal-kicks and corners on the upper side of the pitch
+};
+
+constexpr R2StateProperties R2StateTable[]={
+    {"Inactive", false, false, false}, {"Ready", false, false, false}, {"Kickoff1", true, false, false}, {"Kickoff2", true, true, false},
+    {"Play", false, false, false}, {"Stopped", false, false, false},
+    {"Goalkick1up", true, false, true}, {"Goalkick1down", true, false, false}, {"Goalkick2up", true, true, true}, {"Goalkick2down", true, true, false},
+    {"Corner1up", true, false, true}, {"Corner1down", true, false, false}, {"Corner2up", true, true, true}, {"Corner2down", true, true, false},
+    {"Throwin1", true, false, false}, {"Throwin2", true, true, false},
+    {"Paused", false, false, false}, {"Halftime", false, false, false}, {"Goal1", false, false, false}, {"Goal2", false, false, false},
+    {"Ended", false, false, false}, {"Unknown", false, false, false}
+};
+constexpr int R2StateCount=int(R2State::Ended)+1;
+static_assert(sizeof(R2StateTable)/sizeof(R2StateTable[0])==R2StateCount+1, "R2StateTable needs an entry for each R2State and one for the unknown ones");
+
+constexpr int stateIndex(R2State state){ return (unsigned(state)<unsigned(R2StateCount)) ? int(state) : R2StateCount; }
+constexpr const R2StateProperties& stateProperties(R2State state){ return R2StateTable[stateIndex(state)]; }
+
 struct R2ObjectInfo {
     Vec2 pos, velocity;
 
-    R2ObjectInfo(double _x=0.0, double _y=0.0, double _xVelocity=0.0, double _yVelocity=0.0):
+    R2ObjectInfo(R2Scalar _x=0.0, R2Scalar _y=0.0, R2Scalar _xVelocity=0.0, R2Scalar _yVelocity=0.0):
         pos(_x, _y), velocity(_xVelocity, _yVelocity) {}
 
-    double absVelocity() { return velocity.len(); };
-    double absDistanceFromCenter() { return pos.len(); };
+    R2Scalar absVelocity() { return velocity.len(); };
+    R2Scalar absDistanceFromCenter() { return pos.len(); };
 
-    std::pair<double, Vec2> dist(R2ObjectInfo& obj){
+    std::pair<R2Scalar, Vec2> dist(R2ObjectInfo& obj){
         Vec2 d = obj.pos - pos;
-        return std::pair<double, Vec2> { d.len(), d};
+        return std::pair<R2Scalar, Vec2> { d.len(), d};
     }
 };
 
 struct R2PlayerInfo : R2ObjectInfo {
-    double direction; //<! where's pointing the front of the player. In radiants. 0.0 points towards right of the field.
+    R2Scalar direction; //<! where's pointing the front of the player. In radiants. 0.0 points towards right of the field.
     bool acted; //if it already acted during this tick
-    R2PlayerInfo(double _x=0.0, double _y=0.0, double _xVelocity=0.0, double _yVelocity=0.0, double _direction=0.0) : R2ObjectInfo(_x, _y, _xVelocity, _yVelocity) , direction(_direction), acted(false) {}
+    R2PlayerInfo(R2Scalar _x=0.0, R2Scalar _y=0.0, R2Scalar _xVelocity=0.0, R2Scalar _yVelocity=0.0, R2Scalar _direction=0.0) : R2ObjectInfo(_x, _y, _xVelocity, _yVelocity) , direction(_direction), acted(false) {}
 };
 
+// the players of a team are stored inside the environment up to a full team of 11, so that copying the environment does not allocate
+constexpr int R2TeamInlinePlayers=11;
+typedef R2SmallVector<R2PlayerInfo, R2TeamInlinePlayers> R2Team;
+
 struct R2Environment {
     int tick;    //!<current tick
     int score1;
     int score2;
     R2State state;
     R2ObjectInfo ball;
-    std::vector<R2PlayerInfo> teams[2];
+    R2Team teams[2];
 
     bool lastTouchedTeam2;  
-    double startingTeamMaxRange;    // max movement done by the team that is starting the kick (goal kick, throwin, corner)
+    R2Scalar startingTeamMaxRange;    // max movement done by the team that is starting the kick (goal kick, throwin, corner)
     int ballCatched;        // if >0 the ball is catched and only the goalkeeper can kick it and the ball moves with him. The value indicates how many ticks long the goalkeeper can hold the ball.
     bool ballCatchedTeam2;  // if ballis catched, this says if its catched by Team2 goalkeeper
     bool halftimePassed;
 
     R2Environment(int nPlayers1=0, int nPlayers2=0) :
         tick(0), score1(0), score2(0), state(R2State::Inactive), ball(), 
-        teams{std::vector<R2PlayerInfo>(nPlayers1),std::vector<R2PlayerInfo>(nPlayers2)},
+        teams{R2Team(nPlayers1),R2Team(nPlayers2)},
         lastTouchedTeam2(false), startingTeamMaxRange(0.0), ballCatched(0), ballCatchedTeam2 (false), halftimePassed(false) {}
+
+    // back to the values set by the constructor, keeping the same number of players and without reallocating them
+    void reset(){
+        tick=0; score1=0; score2=0; state=R2State::Inactive; ball=R2ObjectInfo();
+        std::fill(teams[0].begin(), teams[0].end(), R2PlayerInfo());
+        std::fill(teams[1].begin(), teams[1].end(), R2PlayerInfo());
+        lastTouchedTeam2=false; startingTeamMaxRange=0.0; ballCatched=0; ballCatchedTeam2=false; halftimePassed=false;
+    }
 };
 
 struct R2GameState {
     R2EnvSettings sett;
     R2Environment env;
     R2Pitch pitch;
-    R2GameState(R2EnvSettings _sett, R2Environment _env, R2Pitch _pitch) : sett(_sett), env(_env), pitch(_pitch) {}
+    R2GameState(const R2EnvSettings& _sett, const R2Environment& _env, const R2Pitch& _pitch) : sett(_sett), env(_env), pitch(_pitch) {}
 };
 
 enum class R2ActionType {
@@ -283,19 +331,49 @@ enum class R2ActionType {
 
 struct R2Action {
     R2ActionType action;
-    double data[3];
+    R2Scalar data[3];
 
-    R2Action(R2ActionType actionType=R2ActionType::NoOp, double data1=0.0, double data2=0.0, double data3=0.0):
+    R2Action(R2ActionType actionType=R2ActionType::NoOp, R2Scalar data1=0.0, R2Scalar data2=0.0, R2Scalar data3=0.0):
         action(actionType), data{data1, data2, data3} {}
 };
 
+// a game state as received by a player agent (e.g. to build a corpus for benchmarking agents)
+struct R2StateSample {
+    int team;
+    int player;
+    R2GameState state;
+    R2StateSample(int _team, int _player, const R2GameState& _state) : team(_team), player(_player), state(_state) {}
+};
+
+// a game state observed by the agents when their step() runs late (see R2Simulator::setObservationLatency()), with the actions chosen on it
+struct R2PipelineSlot {
+    R2GameState state;
+    std::vector<R2Action> actions;  // indexed as first team players followed by second team players
+    std::vector<uint64_t> ns;       // step() latency of each agent
+    R2PipelineSlot(const R2GameState& _state, int players) : state(_state), actions(players), ns(players, 0) {}
+};
+
+// saving and loading of state samples in a text file, with full precision
+bool saveStateSamples(std::string filename, const std::vector<R2StateSample>& samples);
+std::vector<R2StateSample> loadStateSamples(std::string filename);
+
+// 64 bit hash of all the fields of an environment, taking the exact bits of the floating point values:
+// it is the same on every machine and build producing the same trajectory.
+uint64_t hashEnvironment(const R2Environment& env);
+
 class R2Player {
 public:
     virtual R2Action step(const R2GameState gameState) = 0;
+    // true if step() may run on another thread, at the same time as the step() of other agents (see R2Simulator::setAgentThreads()
+    // and R2Simulator::setObservationLatency()). Agents have to declare it by overriding this: by default they are called serially.
+    virtual bool isThreadSafe() { return false; }
+    // called by R2Simulator::reset(): agents with an internal state (memory of the previous ticks, random generators) should bring it back
+    // to how it was at construction, so that a reset simulator plays the same match as a new one
+    virtual void reset() {}
     virtual ~R2Player() = default; 
 };
 
-std::tuple<int, double, double> intersectionSegmentCircle(Vec2 s1, Vec2 s2, Vec2 c1, double r);
+std::tuple<int, R2Scalar, R2Scalar> intersectionSegmentCircle(Vec2 s1, Vec2 s2, Vec2 c1, R2Scalar r);
 
 struct R2ActionRecord{
     int team;
@@ -314,38 +392,38 @@ R2History(int ticks, int nplayers1, int nplayers2) : envs(ticks+1), actions(tick
 };
 
 struct R2BallPlayerCollision{
-    double t;
+    R2Scalar t;
     int p;
     int team;
-    R2BallPlayerCollision(double _t, int _p, int _team) : 
+    R2BallPlayerCollision(R2Scalar _t, int _p, int _team) : 
         t(_t), p(_p), team(_team) {}
 };
 
 struct R2PoleBallCollision{
     bool collision;
-    double t;
+    R2Scalar t;
     int pole;   
-    R2PoleBallCollision(bool _collision, double _t, int _pole) : 
+    R2PoleBallCollision(bool _collision, R2Scalar _t, int _pole) : 
         collision(_collision), t(_t), pole(_pole) {}
 };
 
 struct R2PolePlayerCollision{
-    double t;
+    R2Scalar t;
     int p;
     int team;
     int pole;
-    R2PolePlayerCollision(double _t, int _p, int _team, int _pole) : 
+    R2PolePlayerCollision(R2Scalar _t, int _p, int _team, int _pole) : 
         t(_t), p(_p), team(_team), pole(_pole) {}
 };
 
 struct R2PlayerPlayerCollision{
-    double t;
+    R2Scalar t;
     int p1;
     int team1;
     int p2;
     int team2;
 
-    R2PlayerPlayerCollision(double _t, int _p1, int _team1, int _p2, int _team2) : 
+    R2PlayerPlayerCollision(R2Scalar _t, int _p1, int _team1, int _p2, int _team2) : 
         t(_t), p1(_p1), team1(_team1), p2(_p2), team2(_team2) {}
 };
 
@@ -357,10 +435,96 @@ enum class R2CollisionType {
     PlayerPlayer
 };
 
+constexpr int R2CollisionTypeCount=int(R2CollisionType::PlayerPlayer)+1;
+
 struct R2CollisionTime{
-    double t;
+    R2Scalar t;
+    R2CollisionType type;
+    R2CollisionTime(R2Scalar _t, R2CollisionType _type): t(_t), type(_type){}
+};
+
+// a collision foreseen by the event-driven solver (see R2Simulator::setEventDrivenCollisions())
+struct R2PredictedCollision{
+    R2Scalar t;   // from the beginning of the tick, in (0,1]
     R2CollisionType type;
-    R2CollisionTime(double _t, R2CollisionType _type): t(_t), type(_type){}
+    int object1;    // the pole for PoleBall and PolePlayer, otherwise a player
+    int object2;    // a player, or the ball. Players are numbered as the first team followed by the second one, and the ball follows them
+    uint32_t version1, version2;    // versions of the moving objects when the collision was foreseen
+    R2PredictedCollision(R2Scalar _t, R2CollisionType _type, int _object1, int _object2, uint32_t _version1, uint32_t _version2) :
+        t(_t), type(_type), object1(_object1), object2(_object2), version1(_version1), version2(_version2) {}
+    bool operator>(const R2PredictedCollision& other) const { return t > other.t; }
+};
+
+// what a random number is drawn for: with the counter-based generator each purpose (and each player) has its own stream
+enum class R2RandomPurpose {
+    StartMatch,
+    Shuffle,
+    DashPower,
+    DashDirection,
+    KickPower,
+    KickDirection,
+    ContemporaryKick,
+    Catch,
+    BallNoise,
+    KickoffPosition,
+    HalfPitchPosition,
+    FarFromBall,
+    AvoidPlayers,
+    StaticBall,
+    StaticPlayers,
+    StaticPoleBall,
+    StaticPolePlayers,
+    Count
+};
+
+// counters of what happened during the match (or, when returned by R2Simulator::stepN(), during the last ticks). Index 0 is first team, 1 is second team.
+struct R2Events {
+    int ticks;          //!< ticks played
+    int goals[2];       //!< goals scored
+    int ballOut;        //!< times the ball went out of the pitch (throw-ins, corners and goal-kicks)
+    int kicks[2];       //!< successful kicks
+    int touches[2];     //!< ball-player collisions (kicks excluded)
+    int catches[2];     //!< successful goalkeeper catches
+
+    R2Events() : ticks(0), goals{0,0}, ballOut(0), kicks{0,0}, touches{0,0}, catches{0,0} {}
+
+    R2Events operator-(const R2Events& e) const {
+        R2Events r;
+        r.ticks=ticks-e.ticks;
+        r.ballOut=ballOut-e.ballOut;
+        for(int w=0; w<=1; w++){
+            r.goals[w]=goals[w]-e.goals[w];
+            r.kicks[w]=kicks[w]-e.kicks[w];
+            r.touches[w]=touches[w]-e.touches[w];
+            r.catches[w]=catches[w]-e.catches[w];
+        }
+        return r;
+    }
+};
+
+// counters of the work done by the collision solvers during the match, useful to spot pathological (and expensive) scenarios.
+// "cap hits" are the times a solver stopped because of its iteration limit while still having collisions to solve,
+// "activations" are the times a static solver actually had to separate some objects.
+struct R2PhysicsCounters {
+    int subSteps[MaxCollisionInsideTickLoop+1]; //!< subSteps[n] is how many times manageCollisions() looped n times (the last entry includes the hits on the cap)
+    int collisions[R2CollisionTypeCount];       //!< resolved collisions, indexed by R2CollisionType
+    int collisionsLoopCapHits;          //!< manageCollisions() stopped by MaxCollisionInsideTickLoop
+    int ballInsidePlayersCapHits;       //!< manageBallInsidePlayers() stopped by MaxCollisionLoop
+    int staticBallCapHits;              //!< manageStaticBallCollisions() stopped by MaxCollisionLoop
+    int staticPlayersCapHits;           //!< manageStaticPlayersCollisions() stopped by MaxCollisionLoop
+    int staticPolePlayersCapHits;       //!< manageStaticPolePlayersCollisions() stopped by MaxCollisionLoop
+    int antiBounces;                    //!< ball bouncing back and forth between two players, stopped zeroing their velocities
+    int ballPlayerBlacklists;           //!< ball-player collisions ignored for the rest of the tick because of null relative velocity or distance
+    int ballInsidePlayersActivations;
+    int staticBallActivations;
+    int staticPlayersActivations;
+    int staticPolePlayersActivations;
+    int staticPlayersToleranceStops;    //!< manageStaticPlayersCollisions() stopped with only overlaps not deeper than the tolerance left (see R2Simulator::setStaticRelaxation())
+    int quietTicks;     //!< ticks in which no pair of objects could meet, so that the collisions search has been skipped
+
+    R2PhysicsCounters() : subSteps{}, collisions{}, collisionsLoopCapHits(0), ballInsidePlayersCapHits(0), staticBallCapHits(0),
+        staticPlayersCapHits(0), staticPolePlayersCapHits(0), antiBounces(0), ballPlayerBlacklists(0), ballInsidePlayersActivations(0),
+        staticBallActivations(0), staticPlayersActivations(0), staticPolePlayersActivations(0), staticPlayersToleranceStops(0), quietTicks(0) {}
 };
 
 class R2Simulator{
@@ -369,20 +533,75 @@ private:
         R2Environment env, oldEnv;
         R2Pitch pitch;
         unsigned int random_seed;
-        std::default_random_engine rng;
+        std::minstd_rand0 rng;  // what std::default_random_engine is on libstdc++, but the same with every standard library
+        bool counterRandom;     // if true, the random numbers come from counterRng instead of rng
+        R2CounterRandom counterRng;
+        std::vector<uint32_t> randomDraws;  // numbers drawn in the current tick, for each purpose and player (the last one is for "no player")
+        std::unique_ptr<R2ThreadPool> agentsPool;   // nullptr if agents are run serially
+        std::vector<char> concurrentDecided;    // players whose action of this tick has already been chosen by the agents pool
+        std::vector<R2Action> concurrentActions;
+        std::vector<uint64_t> concurrentNs;
+        int observationLatency;     // ticks of delay of the game state seen by the agents, 0 if they see the current one
+        std::vector<R2PipelineSlot> pipelineSlots;  // the last observationLatency+1 observations, used as a ring
+        uint64_t pipelineTicks;     // observations submitted to pipelineWorker since it has been started
+        int pipelineCurrent;        // slot with the actions of this tick, -1 if none is ready yet
+        std::vector<char> pipelinedAgents;  // players whose agent decides on pipelineWorker, the thread safe ones (asked on the simulator thread)
+        std::unique_ptr<R2ThreadPool> collisionsPool;   // nullptr if the earliest collisions are always searched serially
+        int collisionsMinPlayers;   // players (both teams) from which collisionsPool is used
+        std::vector<int> collisionsChunkRows;   // first row of each chunk of the parallel search, plus the end
+        std::vector<R2Scalar> collisionsChunkT;   // earliest collision time found in each chunk
+        std::vector<std::vector<R2BallPlayerCollision>> ballPlayerChunkColls;   // collisions tied at that time, in each chunk
+        std::vector<std::vector<R2PlayerPlayerCollision>> playerPlayerChunkColls;
+        R2ImpactTargets impactPlayers;  // positions and velocities of the players (both teams), packed for the time of impact kernel
+        R2ImpactTargets impactPoles;
+        std::vector<R2ImpactScratch> impactScratch;     // one for each chunk of the search (the first one when serial)
+        bool eventDrivenCollisions;     // if true manageCollisions() updates only the predictions of the objects that changed motion
+        bool quiescenceEarlyOut;    // if true manageCollisions() does not search the kinds of collisions that cannot happen in the tick
+        bool quietPlayers;  // set by manageCollisions(): no player may overlap another player or a pole, so manageStaticPlayersCollisions() is skipped
+        std::vector<Vec2> sweepPos;     // players, ball and poles: positions at the beginning of the tick,
+        std::vector<R2Scalar> sweepReach; // and how far from them the objects may reach during the tick
+        std::vector<int> sweepOrder;    // objects sorted by their leftmost reach, kept from a tick to the next
+        std::vector<char> sweepAwake;   // players that may meet another player in the tick, the others sleep during the first search
+        R2Scalar staticTolerance;     // manageStaticPlayersCollisions() stops when no pass separates players overlapping more than this
+        std::vector<R2PredictedCollision> predictedCollisions;  // min-heap on t, including stale predictions that are skipped
+        std::vector<uint32_t> predictedVersions;    // of players and ball, increased when their motion changes
+        std::vector<Vec2> predictedSnapshot;    // positions and velocities of players and ball before a collision is handled
+        std::vector<char> predictedChanged;
+        std::vector<R2PredictedCollision> predictedTies;
         std::normal_distribution<double> normalDist;
         std::uniform_real_distribution<double> uniformDist;
         std::vector<std::shared_ptr<R2Player>> teams[2];
         std::vector<int> shuffledPlayers;
         bool startedTeam2;
         bool ballAlreadyKicked;
-        const std::set<R2State> notStarterStates;
-        const std::set<R2State> team2StarterStates;
         R2History history;
+        bool historyEnabled;
         int processedActions;
         std::string teamNames[2];
-        double cosKickableAngle;
-        double cosCatchableAngle;
+        R2Scalar cosKickableAngle;
+        R2Scalar cosCatchableAngle;
+        R2Events events;
+        std::vector<bool> givenActions;     // players whose action is given by stepN() instead of asked to their agent
+        std::vector<R2Action> givenActionsValues;
+        R2Profile profile;  // filled only when compiled with _R2S_PROFILE
+        R2PhysicsCounters physics;
+        std::vector<R2AgentLatency> agentLatency[2];
+        R2AgentLatency teamLatency[2];
+        uint64_t stepTimeBudgetNs;  // 0 if there is no budget
+        bool agentLatencyTracking;  // see setAgentLatencyTracking()
+        std::vector<R2StateSample>* capturedStates;
+        int captureEveryTicks;
+        bool stateHashing;  // see setStateHashing()
+        std::vector<uint64_t> stateHashes;  // indexed by tick, empty if stateHashing is false
+        uint64_t stateDigest;
+        R2GameState agentsState;    // game state given to the agents, refreshed in place so that its storage is reused
+        std::vector<int> lastPlayerPlayerCollisions;    // manageCollisions() working storage, kept to not allocate it at each tick
+        std::vector<bool> ballPlayerBlacklist;
+        std::vector<R2CollisionTime> earlierCollisions;
+        std::vector<R2PolePlayerCollision> firstPolePlayersColls;
+        std::vector<R2BallPlayerCollision> firstBallPlayerColls;
+        std::vector<R2PlayerPlayerCollision> firstPlayerPlayerColls;
+        std::unique_ptr<R2AsyncWorker> pipelineWorker;  // last, so that it is stopped before the members it uses are destroyed
 
         bool isBallOutUp(){return (env.ball.pos.y > pitch.y1);}
         bool isBallOutDown(){return (env.ball.pos.y < pitch.y2);}
@@ -391,6 +610,12 @@ private:
         bool isBallOut(){return (isBallOutUp()||isBallOutDown()||isBallOutLeft()||isBallOutRight());}
         
         void resetPlayersActed();
+        void recordStateHash();
+        uint32_t nextRandomIndex(R2RandomPurpose purpose, int team, int player);
+        double randomUniform(R2RandomPurpose purpose, int team=-1, int player=0);
+        double randomNormal(R2RandomPurpose purpose, int team=-1, int player=0);
+        void shufflePlayers();
+        const R2GameState& refreshAgentsState();
         void setBallThrowInPosition();
         bool isBallInGoal(const int team);  // Team is the one scoring
         bool isGoalScored(const int team);
@@ -405,12 +630,12 @@ private:
         void limitSpeed();
         void decayPlayerSpeed(R2PlayerInfo& p);
         void decaySpeed();
-        void putPlayersFarFromBall(int team, double minDist);
+        void putPlayersFarFromBall(int team, R2Scalar minDist);
         Vec2 avoidOtherPlayersPosition(Vec2 pos, int team, int player);
         void actionMove(const R2Action& action, int team, int player);
         void actionMoveKickoff(const R2Action& action, int team, int player);
         void actionMoveGoalkick(const R2Action& action, int team, int player);
-        void actionMoveThrowinCorner(const R2Action& action, int team, int player, double distanceToBall);
+        void actionMoveThrowinCorner(const R2Action& action, int team, int player, R2Scalar distanceToBall);
         void actionMoveThrowin(const R2Action& action, int team, int player);
         void actionMoveCorner(const R2Action& action, int team, int player);
         void actionDash(const R2Action& action, int team, int player);
@@ -419,7 +644,7 @@ private:
         void setBallCatchedPosition();
         void setBallReleasedPosition();
         void limitPlayersCloseToPitch();
-        void limitPlayersToHalfPitch(int kickTeam, double dueDistance);
+        void limitPlayersToHalfPitch(int kickTeam, R2Scalar dueDistance);
         void limitPlayersToHalfPitchCenterBody(int kickTeam){limitPlayersToHalfPitch(kickTeam, sett.centerRadius);}
         void limitPlayersToHalfPitchFullBody(int kickTeam){limitPlayersToHalfPitch(kickTeam, sett.centerRadius+sett.playerRadius);}
         void limitPlayersOutsideArea(int kickTeam);
@@ -436,36 +661,84 @@ private:
         void procGoal(const R2Action& action, const int team, const int player);
         void procEnded(const R2Action& action, const int team, const int player);
         void preState();
+        void preKickoff();
+        void prePlay();
+        void preStopped();
+        void preGoalkick();
+        void preCorner();
+        void preThrowin();
+        void preHalftime();
         void checkState();
-        std::tuple<bool, double> findPoleObjectCollision(R2ObjectInfo& obj1, Vec2 pole, double radius, double partialT);
-        std::tuple<bool, double> findObjectsCollision(R2ObjectInfo& obj1, R2ObjectInfo&obj2, double radius, double partialT);
-
-        std::tuple<bool, double> findBallPlayerCollision(int team, int player, double partialT);
-        std::vector<R2BallPlayerCollision> findFirstBallPlayersCollisions(double partialT, std::vector<bool>& ballPlayerBlacklist);
-        std::tuple<bool, double> findPlayerPlayerCollision(int team1, int player1, int team2, int player2, double partialT);
-        std::vector<R2PlayerPlayerCollision> findFirstPlayerPlayersCollisions(double partialT, std::vector<int>& playerPlayerCollisions);
+        void checkKickoff();
+        void checkPlay();
+        void checkGoalkick();
+        void checkCorner();
+        void checkThrowin();
+        void checkGoal();
+        // what preState(), checkState() and processStep() do in each state, indexed as R2StateTable (null when nothing)
+        struct R2StateHandlers {
+            void (R2Simulator::*pre)();
+            void (R2Simulator::*check)();
+            void (R2Simulator::*process)(const R2Action& action, const int team, const int player);
+        };
+        static const R2StateHandlers stateHandlers[R2StateCount+1];
+        std::tuple<bool, R2Scalar> findPoleObjectCollision(R2ObjectInfo& obj1, Vec2 pole, R2Scalar radius, R2Scalar partialT);
+        std::tuple<bool, R2Scalar> findObjectsCollision(R2ObjectInfo& obj1, R2ObjectInfo&obj2, R2Scalar radius, R2Scalar partialT);
+
+        std::tuple<bool, R2Scalar> findBallPlayerCollision(int team, int player, R2Scalar partialT);
+        void findFirstBallPlayersCollisions(R2Scalar partialT, std::vector<bool>& ballPlayerBlacklist, std::vector<R2BallPlayerCollision>& collisions);
+        void scanBallPlayersCollisions(int first, int last, R2Scalar partialT, const std::vector<bool>& ballPlayerBlacklist, std::vector<R2BallPlayerCollision>& collisions, R2Scalar& earlierT, R2ImpactScratch& scratch);
+        std::tuple<bool, R2Scalar> findPlayerPlayerCollision(int team1, int player1, int team2, int player2, R2Scalar partialT);
+        void findFirstPlayerPlayersCollisions(R2Scalar partialT, std::vector<int>& playerPlayerCollisions, std::vector<R2PlayerPlayerCollision>& collisions, const std::vector<char>* awake=nullptr);
+        void scanPlayerPlayersCollisions(int firstRow, int lastRow, R2Scalar partialT, const std::vector<int>& playerPlayerCollisions, std::vector<R2PlayerPlayerCollision>& collisions, R2Scalar& earlierT, R2ImpactScratch& scratch, const std::vector<char>* awake);
+        int playerPlayersRowPairs(int row);
+        void packImpactPlayers(int chunks);
+        bool isParallelCollisionsSearch() { return collisionsPool && (int(shuffledPlayers.size()) >= collisionsMinPlayers); };
+        bool isPredictionValid(const R2PredictedCollision& c);
+        void predictCollision(R2CollisionType type, int object1, int object2, bool found, R2Scalar t, R2Scalar partialT);
+        void predictCollisions(R2Scalar partialT);
+        void startPredictedCollisions();
+        void nextPredictedCollisions(R2Scalar partialT, R2PoleBallCollision& poleBall, std::vector<R2PolePlayerCollision>& polePlayers,
+            std::vector<R2BallPlayerCollision>& ballPlayers, std::vector<R2PlayerPlayerCollision>& playerPlayers);
+        void snapshotPredictedObjects();
+        unsigned possibleCollisions();
+        void updatePredictedCollisions(R2Scalar partialT, const R2PoleBallCollision& poleBall, const std::vector<R2PolePlayerCollision>& polePlayers,
+            const std::vector<R2BallPlayerCollision>& ballPlayers, const std::vector<R2PlayerPlayerCollision>& playerPlayers);
        
-        std::tuple<bool, double> findPoleBallCollision(Vec2 pole, double partialT);
-        std::tuple<bool, double> findPolePlayerCollision(int team, int player, Vec2 pole, double partialT);
+        std::tuple<bool, R2Scalar> findPoleBallCollision(Vec2 pole, R2Scalar partialT);
+        std::tuple<bool, R2Scalar> findPolePlayerCollision(int team, int player, Vec2 pole, R2Scalar partialT);
 
-        R2PoleBallCollision findFirstPoleBallCollision(double partialT);
-        std::vector<R2PolePlayerCollision> findFirstPolePlayersCollisions(double partialT);
+        R2PoleBallCollision findFirstPoleBallCollision(R2Scalar partialT);
+        void findFirstPolePlayersCollisions(R2Scalar partialT, std::vector<R2PolePlayerCollision>& collisions);
 
 
         void addBallNoise();
-        void updateMotion(double t);
+        void updateMotion(R2Scalar t);
         void manageCollisions();
         bool manageStaticPoleBallCollisions();
         void manageStaticBallCollisions();
-        bool manageStaticPolePlayersCollisions();
+        bool manageStaticPolePlayersCollisions(bool& shallow);
         void manageStaticPlayersCollisions();
         void updateCollisionsAndMovements();
         bool isAnyTeamPreparingKicking();
         bool isAnyTeamKicking();
         bool isTeam2Kicking(R2State theState);
+        R2Action callAgent(int team, int player, const R2GameState& gameState);
+        void captureState(int team, int player, const R2GameState& gameState);
+        R2Action checkAgentLatency(int team, int player, const R2Action& action, uint64_t ns);
+        bool isTimingAgents() { return agentLatencyTracking || (stepTimeBudgetNs!=0); } // the two clock readings per agent are skipped when nobody needs them
+        void askPlayersActionsConcurrently(const R2GameState& gameState);
+        void startPipeline();
+        void advancePipeline();
+        void decidePipelined(uint64_t ticket);
+        R2Action pipelinedPlayerAction(int team, int player, int index);
+        R2Action askPlayerAction(int team, int player, const R2GameState& gameState);
+        R2Action askPlayerAction(int team, int player);
         void playersAct();
 
         void manageBallInsidePlayers();
+
+        friend struct R2KernelBench;    // the micro-benchmarks in kernel_bench.cpp call the collision functions directly
 public:
     R2Simulator(std::vector<std::shared_ptr<R2Player>> _team1, std::vector<std::shared_ptr<R2Player>> _team2, std::string _team1name=defaultTeam1Name, std::string _team2name=defaultTeam2Name,
       unsigned int _random_seed = createChronoRandomSeed() ,
@@ -474,37 +747,185 @@ public:
         pitch(_settings.pitchWidth, _settings.pitchLength, _settings.goalWidth, _settings.netLength, _settings.poleRadius, _settings.outPitchLimit),
         random_seed (_random_seed),
         rng (_random_seed),
+        counterRandom(false),
+        counterRng(_random_seed),
+        randomDraws(int(R2RandomPurpose::Count)*(_team1.size()+_team2.size()+1), 0),
+        agentsPool(),
+        concurrentDecided(_team1.size()+_team2.size(), 0),
+        concurrentActions(_team1.size()+_team2.size()),
+        concurrentNs(_team1.size()+_team2.size(), 0),
+        observationLatency(0),
+        pipelineSlots(),
+        pipelineTicks(0),
+        pipelineCurrent(-1),
+        pipelinedAgents(),
+        collisionsPool(),
+        collisionsMinPlayers(ParallelCollisionsMinPlayers),
+        collisionsChunkRows(),
+        collisionsChunkT(),
+        ballPlayerChunkColls(),
+        playerPlayerChunkColls(),
+        impactPlayers(),
+        impactPoles(),
+        impactScratch(1),
+        eventDrivenCollisions(false),
+        quiescenceEarlyOut(true),
+        quietPlayers(false),
+        sweepPos(),
+        sweepReach(),
+        sweepOrder(),
+        sweepAwake(),
+        staticTolerance(StaticTolerance),
+        predictedCollisions(),
+        predictedVersions(_team1.size()+_team2.size()+1, 0),
+        predictedSnapshot(2*(_team1.size()+_team2.size()+1)),
+        predictedChanged(_team1.size()+_team2.size()+1, 0),
+        predictedTies(),
         normalDist(), uniformDist(0.0, 1.0),
         teams{_team1, _team2} ,
         shuffledPlayers(_team1.size()+_team2.size(),0),
         startedTeam2(false),
         ballAlreadyKicked(false),
-        notStarterStates({R2State::Inactive, R2State::Ready, R2State::Play, R2State::Stopped, R2State::Paused, R2State::Halftime, R2State::Goal1, R2State::Goal2, R2State::Ended}),
-        team2StarterStates({R2State::Kickoff2, R2State::Goalkick2up, R2State::Goalkick2down, R2State::Corner2up, R2State::Corner2down, R2State::Throwin2}),
         history(_settings.ticksPerTime*2, _team1.size(), _team2.size()),
+        historyEnabled(true),
         processedActions(0),
         teamNames{_team1name ,_team2name},
         cosKickableAngle (cos(sett.kickableAngle)),
-        cosCatchableAngle(cos(sett.catchableAngle))
+        cosCatchableAngle(cos(sett.catchableAngle)),
+        events(),
+        givenActions(_team1.size()+_team2.size(), false),
+        givenActionsValues(_team1.size()+_team2.size()),
+        profile(),
+        physics(),
+        agentLatency{std::vector<R2AgentLatency>(_team1.size()), std::vector<R2AgentLatency>(_team2.size())},
+        teamLatency(),
+        stepTimeBudgetNs(0),
+        agentLatencyTracking(false),
+        capturedStates(nullptr),
+        captureEveryTicks(1),
+        stateHashing(true),
+        stateHashes(_settings.ticksPerTime*2+1, 0),
+        stateDigest(0),
+        agentsState(sett, env, pitch),
+        lastPlayerPlayerCollisions(),
+        ballPlayerBlacklist(),
+        earlierCollisions(),
+        firstPolePlayersColls(),
+        firstBallPlayerColls(),
+        firstPlayerPlayerColls(),
+        pipelineWorker()
         {
             std::iota (std::begin(shuffledPlayers), std::end(shuffledPlayers), 0);
         }
 
+    // brings the simulator back to the beginning of a match with a new random seed (and optionally new settings), reusing the allocated storage.
+    // The player agents are kept, and their reset() is called: with agents that restore their internal state there (as SimplePlayer does),
+    // the match is the same as the one of a new simulator built with the same seed.
+    void reset(unsigned int _random_seed);
+    void reset(unsigned int _random_seed, const R2EnvSettings& _settings);
     void setStartMatch();
     void setHalfTime();
     void playMatch();
     void step();
     bool stepIfPlaying();
+    // plays up to k ticks (less if the match ends) and returns what happened during them.
+    // actions, if not empty, are indexed as first team players followed by second team players: those players
+    // do not have their step() called and perform the given action at each of the k ticks, whatever the game state is.
+    // given, if not empty, selects which of the actions are used (the other players are asked to their agent as usual).
+    R2Events stepN(int k, const std::vector<R2Action>& actions=std::vector<R2Action>(), const std::vector<bool>& given=std::vector<bool>());
+    R2Events getEvents() { R2Events e=events; e.ticks=std::max(env.tick,0); return e; };
     R2GameState getGameState() { return R2GameState(sett, env, pitch); };
     std::vector<std::string> getTeamNames();
     std::string getStateString();
     unsigned int getRandomSeed() { return random_seed;};
+    // by default random numbers are drawn in sequence from a single generator. The counter-based generator (see random.h) draws each of
+    // them from (seed, tick, purpose, player) instead, so they do not depend on the order in which players and collisions are evaluated,
+    // nor on the standard library; normal numbers come from a faster ziggurat. Matches are reproducible with both, but they are different.
+    // It should be set before the beginning of the match, and it is kept by reset().
+    void setCounterBasedRandom(bool enabled) { counterRandom=enabled; };
+    // with threads > 1, during play (when all the players receive the same game state) the step() of the agents runs concurrently on that many threads,
+    // then the actions are processed serially in the usual order, so the match is the same as with serial agents.
+    // Only agents whose isThreadSafe() returns true (it is false by default) run concurrently, the others are always called serially.
+    // 0 or 1 restore the default serial calls.
+    void setAgentThreads(int threads);
+    int getAgentThreads() { return agentsPool ? agentsPool->size() : 1; };
+    // with ticks > 0 the agents act on a stale game state: the action of tick t is chosen by step() on the game state that the agents
+    // would have received at tick t-ticks, and the thread safe agents run on a background thread, overlapping the physics of the following ticks.
+    // All the agents receive that same delayed state in every game phase, also when taking a kick. During the first ticks of the match,
+    // before any decision is ready, players perform NoOp. Agents whose isThreadSafe() returns false (the default) are called on the simulator thread
+    // with the delayed state. It is kept by reset(), and 0 (the default) restores the immediate game state.
+    void setObservationLatency(int ticks);
+    int getObservationLatency() { return observationLatency; };
+    // with threads > 1 and at least minPlayers players on the pitch (both teams), the search for the earliest ball-player and player-player
+    // collisions is split among that many threads. The results are the same as the serial search: same earliest time, same tied collisions
+    // in the same order. Useful only with very large teams: with few players the threads synchronization costs more than the search.
+    // 0 or 1 restore the serial search.
+    void setCollisionThreads(int threads, int minPlayers=ParallelCollisionsMinPlayers);
+    int getCollisionThreads() { return collisionsPool ? collisionsPool->size() : 1; };
+    // by default, after each collision handled in a tick all the times of impact are searched again for the rest of the tick.
+    // The event-driven solver keeps them in a priority queue instead, and searches again only those of the objects whose motion changed,
+    // with the same rules (earliest collisions handled together, players just collided not colliding again, ball-player blacklist,
+    // MaxCollisionInsideTickLoop). The times of the other objects are not recomputed from their new positions, so they may differ
+    // in the last bits from the default solver: matches are reproducible with both, but they are not the same.
+    void setEventDrivenCollisions(bool enabled) { eventDrivenCollisions=enabled; };
+    bool isEventDrivenCollisions() { return eventDrivenCollisions; };
+    // by default manageCollisions() first checks which pairs of objects could meet in the tick, and skips the searches of the kinds of
+    // collisions that cannot happen (all of them in most ticks), and the static checks of the players that cannot overlap. The results are
+    // the same with the early-out disabled, that is useful only to measure it.
+    void setQuiescenceEarlyOut(bool enabled) { quiescenceEarlyOut=enabled; };
+    bool isQuiescenceEarlyOut() { return quiescenceEarlyOut; };
+    // when the game is not active overlapping players are separated by relaxation: each pass pushes apart every overlapping pair, until
+    // no pair overlaps more than tolerance or after MaxCollisionLoop passes. The players pushed exactly at contact distance often still
+    // overlap by a rounding error, so with tolerance 0 crowded set pieces run all the passes; the default StaticTolerance stops them once
+    // only those overlaps are left. Matches with tolerance 0, like the ones of the reference engine (see diff_check.cpp), are not the same.
+    void setStaticRelaxation(R2Scalar tolerance) { staticTolerance=std::max(R2Scalar(0.0), tolerance); };
+    R2Scalar getStaticRelaxationTolerance() { return staticTolerance; };
+    bool isCounterBasedRandom() { return counterRandom; };
     std::string createDateFilename();
     bool saveStatesHistory(std::string filename);
     bool saveStatesHistory(){ return saveStatesHistory(createDateFilename().append(".states.txt")); }
     bool saveActionsHistory(std::string filename);
     bool saveActionsHistory(){ return saveActionsHistory(createDateFilename().append(".actions.txt")); }
-    bool saveHistory(){ std::string fn1,fn2=createDateFilename(); fn1=fn2; bool r=saveStatesHistory(fn1.append(".states.txt")); return ( saveActionsHistory(fn2.append(".actions.txt")) && r);}
+    bool saveHistory(){ std::string fn1,fn2,fn3,fn4=createDateFilename(); fn1=fn4; fn2=fn4; fn3=fn4; bool r=saveStatesHistory(fn1.append(".states.txt")); r=saveActionsHistory(fn2.append(".actions.txt")) && r; r=savePhysicsCounters(fn3.append(".physics.txt")) && r; if(stateHashing) r=saveStateHashes(fn4.append(".hashes.txt")) && r; return r;}
+    const R2History& getHistory() { return history; };
+    int getHistoryStatesLength();   // how many entries of history.envs have been recorded so far
+    int getHistoryActionsLength();  // how many entries of history.actions have been recorded so far
+    // history is recorded by default. Disabling it releases its memory, and saved histories will be empty.
+    void setHistoryEnabled(bool enabled);
+    bool isHistoryEnabled() { return historyEnabled; };
+    const R2Profile& getProfile() { return profile; };  // phases timing, all zeros unless compiled with _R2S_PROFILE
+    void clearProfile() { profile.clear(); };
+    const R2PhysicsCounters& getPhysicsCounters() { return physics; };
+    bool savePhysicsCounters(std::string filename);
+    bool savePhysicsCounters(){ return savePhysicsCounters(createDateFilename().append(".physics.txt")); }
+    const R2AgentLatency& getAgentLatency(int team, int player) { return agentLatency[team][player]; };
+    const R2AgentLatency& getTeamLatency(int team) { return teamLatency[team]; };
+    std::string getAgentLatencyString();
+    // if enabled, the time taken by each step() of the agents is recorded in getAgentLatency() and getTeamLatency(), and reported by
+    // getAgentLatencyString(). It is off by default, so that the agents are called without reading the clock. It does not change the match.
+    void setAgentLatencyTracking(bool enabled) { agentLatencyTracking=enabled; };
+    bool isAgentLatencyTracking() { return agentLatencyTracking; };
+    // if seconds > 0, a player whose step() takes longer than that gets NoOp as action for that tick (making the match non reproducible),
+    // and the overrun is counted in getAgentLatency(), whose times are recorded only if setAgentLatencyTracking() is enabled too.
+    // The budget does not preempt the agent: step() always runs to the end, and only then its action is discarded, so a slow agent
+    // still slows down the match.
+    void setStepTimeBudget(double seconds) { stepTimeBudgetNs= (seconds>0.0) ? uint64_t(seconds*1e9) : 0; };
+    double getStepTimeBudget() { return double(stepTimeBudgetNs)*1e-9; };
+    // appends to samples the game states given to the agents, once every everyTicks ticks. Use nullptr to stop capturing.
+    void captureStates(std::vector<R2StateSample>* samples, int everyTicks=1) { capturedStates=samples; captureEveryTicks=std::max(everyTicks, 1); };
+    // if enabled (the default), hashEnvironment() of the environment is computed at the end of every tick, also with history disabled.
+    // The whole environment is hashed every time: about 50 ns per tick with 4 players per team and 120 ns with 11, below 1% of a tick
+    // both with SimplePlayer agents and with actions given through stepN(), so it can be left on. Disabling it saves that time and releases
+    // the memory of the hashes; it should be changed before the beginning of the match, and it is kept by reset().
+    // getStateHash(t) is the hash of history envs[t], 0 for ticks not played yet. The digest combines the hashes of all the ticks played since
+    // the last reset, so two matches with the same digest had the same trajectory, and the first differing tick can be found comparing the hashes.
+    void setStateHashing(bool enabled);
+    bool isStateHashing() { return stateHashing; };
+    uint64_t getStateDigest() { return stateDigest; };
+    uint64_t getStateHash(int tick) { return ((tick>=0) && (tick<int(stateHashes.size()))) ? stateHashes[tick] : 0; };
+    const std::vector<uint64_t>& getStateHashes() { return stateHashes; };
+    bool saveStateHashes(std::string filename);    // false, writing nothing, if hashing is disabled
+    bool saveStateHashes(){ return saveStateHashes(createDateFilename().append(".hashes.txt")); }
 
     void setEnvironment(int _tick, int _score1, int _score2, R2State _state, R2ObjectInfo _ball, 
         std::vector<R2PlayerInfo> _team1, std::vector<R2PlayerInfo> _team2,
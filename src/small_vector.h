@@ -0,0 +1,106 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d : vector with inline storage for a few items, used for the teams of the environment so that copying it does not allocate
+#ifndef R2S_SMALL_VECTOR_H
+#define R2S_SMALL_VECTOR_H
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+
+namespace r2s {
+
+// Up to N items are kept inside the object itself, more than N in a std::vector. Copies copy only the items in use:
+// with no more than N items they never allocate, and neither does assigning to an object whose heap storage is large enough.
+// It has the part of the interface of std::vector used by the simulator; iterators are pointers, invalidated by any change of size.
+template <typename T, int N>
+class R2SmallVector {
+    T local[N];
+    std::vector<T> heap;    // the items when they are more than N, otherwise empty
+    int count;
+
+public:
+    R2SmallVector() : count(0) {}
+    explicit R2SmallVector(int n) : count(0) { resize(n); }
+    R2SmallVector(const R2SmallVector& other) : count(0) { assign(other.begin(), other.end()); }
+    R2SmallVector(R2SmallVector&& other) : count(0) { *this=std::move(other); }
+    R2SmallVector& operator=(const R2SmallVector& other){
+        if(this!=&other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+    R2SmallVector& operator=(R2SmallVector&& other){
+        if(this==&other)
+            return *this;
+        if(other.count<=N)
+            std::copy(other.local, other.local+other.count, local);
+        heap=std::move(other.heap);
+        count=other.count;
+        other.heap.clear();
+        other.count=0;
+        return *this;
+    }
+
+    template <typename It>
+    void assign(It first, It last){
+        int n=int(std::distance(first, last));
+        if(n<=N){
+            std::copy(first, last, local);
+            heap.clear();
+        }
+        else
+            heap.assign(first, last);
+        count=n;
+    }
+
+    void resize(int n, const T& value=T()){
+        if(n<=N){
+            if(count>N){
+                std::copy(heap.begin(), heap.begin()+n, local);
+                heap.clear();
+            }
+            else if(n>count)
+                std::fill(local+count, local+n, value);
+        }
+        else{
+            if(count<=N)
+                heap.assign(local, local+count);
+            heap.resize(n, value);
+        }
+        count=n;
+    }
+
+    void push_back(const T& value){
+        if(count<N)
+            local[count]=value;
+        else if(count==N){
+            T item=value;   // value may be one of the local items
+            heap.reserve(2*N);
+            heap.assign(local, local+N);
+            heap.push_back(item);
+        }
+        else
+            heap.push_back(value);
+        count++;
+    }
+
+    void clear(){ count=0; heap.clear(); }
+
+    size_t size() const { return size_t(count); }
+    bool empty() const { return count==0; }
+    T* data() { return (count<=N) ? local : heap.data(); }
+    const T* data() const { return (count<=N) ? local : heap.data(); }
+    T* begin() { return data(); }
+    T* end() { return data()+count; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data()+count; }
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    T& back() { return data()[count-1]; }
+    const T& back() const { return data()[count-1]; }
+};
+
+} // end namespace
+
+#endif // R2S_SMALL_VECTOR_H
@@ -0,0 +1,203 @@
+// (c) 2021 Ruggero Rossi
+// robosoc2d : minimal pool of worker threads, used to run the player agents of a tick concurrently, and a single background worker for the pipelined agents
+#ifndef R2S_THREAD_POOL_H
+#define R2S_THREAD_POOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <vector>
+#include <cstdint>
+
+namespace r2s {
+
+class R2ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeUp, finished;
+    void (*invoke)(const void* job, int i);  // calls the job, whose type is erased without allocating
+    const void* job;
+    int jobSize;
+    std::atomic<int> nextIndex;
+    int busyWorkers;
+    unsigned long long generation;  // increased at each parallelFor(), it tells the workers there is a new job
+    bool stopping;
+    std::exception_ptr error;
+
+    // runs the job on the indexes not taken yet by the other threads
+    void work(){
+        for(int i=nextIndex++; i<jobSize; i=nextIndex++){
+            try{
+                invoke(job, i);
+            }
+            catch(...){
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!error)
+                    error=std::current_exception();
+            }
+        }
+    }
+
+    void workerLoop(){
+        unsigned long long seen=0;
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [&]{ return stopping || (generation!=seen); });
+                if(stopping)
+                    return;
+                seen=generation;
+            }
+            work();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busyWorkers--;
+            }
+            finished.notify_one();
+        }
+    }
+
+public:
+    // threads includes the calling one, so threads-1 workers are created
+    explicit R2ThreadPool(int threads) : invoke(nullptr), job(nullptr), jobSize(0), nextIndex(0), busyWorkers(0), generation(0), stopping(false) {
+        for(int t=1; t<threads; t++)
+            workers.emplace_back(&R2ThreadPool::workerLoop, this);
+    }
+
+    ~R2ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping=true;
+        }
+        wakeUp.notify_all();
+        for(auto& w : workers)
+            w.join();
+    }
+
+    R2ThreadPool(const R2ThreadPool&) = delete;
+    R2ThreadPool& operator=(const R2ThreadPool&) = delete;
+
+    int size() const { return int(workers.size())+1; }
+
+    // calls f(i) for every i in [0,n), on the workers and on the calling thread, returning when all the calls are over.
+    // The first exception thrown by f is rethrown here.
+    template<typename F>
+    void parallelFor(int n, const F& f){
+        if(n<=0)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            invoke=[](const void* j, int i){ (*static_cast<const F*>(j))(i); };
+            job=&f;
+            jobSize=n;
+            nextIndex=0;
+            busyWorkers=int(workers.size());
+            error=nullptr;
+            generation++;
+        }
+        wakeUp.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]{ return busyWorkers==0; });
+        job=nullptr;
+        if(error)
+            std::rethrow_exception(error);
+    }
+};
+
+// a single thread running job(0), job(1), job(2)... in order, one for each submit(), while the caller goes on
+class R2AsyncWorker {
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable submittedCv, doneCv;
+    std::function<void(uint64_t)> job;
+    uint64_t submitted;
+    uint64_t done;
+    bool stopping;
+    std::exception_ptr error;
+
+    void workerLoop(){
+        while(true){
+            uint64_t ticket;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                submittedCv.wait(lock, [&]{ return stopping || (done<submitted); });
+                if(done==submitted)   // stopping, and nothing left to do
+                    return;
+                ticket=done;
+            }
+            try{
+                job(ticket);
+            }
+            catch(...){
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!error)
+                    error=std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done++;
+            }
+            doneCv.notify_all();
+        }
+    }
+
+public:
+    explicit R2AsyncWorker(std::function<void(uint64_t)> _job) : job(std::move(_job)), submitted(0), done(0), stopping(false) {
+        worker=std::thread(&R2AsyncWorker::workerLoop, this);
+    }
+
+    // the jobs already submitted are completed before returning
+    ~R2AsyncWorker(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping=true;
+        }
+        submittedCv.notify_all();
+        worker.join();
+    }
+
+    R2AsyncWorker(const R2AsyncWorker&) = delete;
+    R2AsyncWorker& operator=(const R2AsyncWorker&) = delete;
+
+    // queues a new job, returning the ticket that job() will receive
+    uint64_t submit(){
+        uint64_t ticket;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ticket=submitted++;
+        }
+        submittedCv.notify_one();
+        return ticket;
+    }
+
+    // waits for the end of the job with that ticket (and of all the previous ones). The first exception thrown by a job is rethrown here.
+    void wait(uint64_t ticket){
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCv.wait(lock, [&]{ return done>ticket; });
+        if(error){
+            std::exception_ptr e=error;
+            error=nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    // waits for the end of all the submitted jobs
+    void drain(){
+        uint64_t last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(submitted==0)
+                return;
+            last=submitted-1;
+        }
+        wait(last);
+    }
+};
+
+} // end namespace
+
+#endif // R2S_THREAD_POOL_H
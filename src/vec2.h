@@ -11,64 +11,71 @@
 #else // __linux__ 
 #endif
 
-#define _USE_MATH_DEFINES
-#include <cmath>
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include "fast_trig.h"
 
 namespace r2s {
 
-struct Vec2 {
-	double x, y;
+// the floating point type of the simulator: double, or float if compiled with _R2S_FLOAT (on CMake use the option -DROBOSOC2D_FLOAT=ON)
+#ifdef _R2S_FLOAT
+typedef float R2Scalar;
+#else
+typedef double R2Scalar;
+#endif
+
+template <typename T>
+struct Vec2T {
+	T x, y;
 public:
-	Vec2() : x(0), y(0) {}
-	Vec2(double x, double y) : x(x), y(y) {}
-	Vec2(const Vec2& v) : x(v.x), y(v.y) {}
-	Vec2(double angle) : x(cos(angle)), y(sin(angle)) {}
-	Vec2& operator=(const Vec2& v) { x = v.x; y = v.y; return *this; }
-	void set(double vx, double vy) { x = vx; y = vy; }
+	Vec2T() : x(0), y(0) {}
+	Vec2T(T x, T y) : x(x), y(y) {}
+	Vec2T(const Vec2T& v) : x(v.x), y(v.y) {}
+	Vec2T(T angle) { fsincos(angle, y, x); }
+	Vec2T& operator=(const Vec2T& v) { x = v.x; y = v.y; return *this; }
+	void set(T vx, T vy) { x = vx; y = vy; }
 	void zero() { x=0.0; y=0.0; }
 	void invert() { x=-x; y=-y;}
-	Vec2 operator+(const Vec2& v) { return Vec2(x + v.x, y + v.y); }
-	Vec2 operator-(const Vec2& v) { return Vec2(x - v.x, y - v.y); }
-	Vec2& operator+=(const Vec2& v) { x += v.x; y += v.y; return *this; }
-	Vec2& operator-=(const Vec2& v) { x -= v.x; y -= v.y; return *this; }
-	Vec2& add(double vx, double vy) { x += vx; y += vy; return *this; }
-	Vec2& sub(double vx, double vy) { x -= vx; y -= vy; return *this; }
-	Vec2 operator*(double k) { return Vec2(x * k, y * k); }
-	Vec2 operator/(double k) { return Vec2(x / k, y / k); }
-	Vec2& operator*=(double k) { x *= k; y *= k; return *this; }
-	Vec2& operator/=(double k) { x /= k; y /= k; return *this; }
-	double len() const { return sqrt(x * x + y * y); }
+	Vec2T operator+(const Vec2T& v) { return Vec2T(x + v.x, y + v.y); }
+	Vec2T operator-(const Vec2T& v) { return Vec2T(x - v.x, y - v.y); }
+	Vec2T& operator+=(const Vec2T& v) { x += v.x; y += v.y; return *this; }
+	Vec2T& operator-=(const Vec2T& v) { x -= v.x; y -= v.y; return *this; }
+	Vec2T& add(T vx, T vy) { x += vx; y += vy; return *this; }
+	Vec2T& sub(T vx, T vy) { x -= vx; y -= vy; return *this; }
+	Vec2T operator*(T k) { return Vec2T(x * k, y * k); }
+	Vec2T operator/(T k) { return Vec2T(x / k, y / k); }
+	Vec2T& operator*=(T k) { x *= k; y *= k; return *this; }
+	Vec2T& operator/=(T k) { x /= k; y /= k; return *this; }
+	T len() const { return std::sqrt(x * x + y * y); }
 
 	void norm() {
-		double l = len();
+		T l = len();
 		if (l != 0.0) {
-			double k = 1.0 / l;
+			T k = T(1.0) / l;
 			x *= k;
 			y *= k;
 		}
 	}
-	void resize(double length) { norm(); x *= length; y *= length; }
-	double dist(const Vec2& v) const { Vec2 d(v.x - x, v.y - y); return d.len(); }
+	void resize(T length) { norm(); x *= length; y *= length; }
+	T dist(const Vec2T& v) const { Vec2T d(v.x - x, v.y - y); return d.len(); }
 
-	void rot(double rad) {
-		double c = cos(rad);
-		double s = sin(rad);
-		double rx = x * c - y * s;
-		double ry = x * s + y * c;
+	void rot(T rad) {
+		T c, s;
+		fsincos(rad, s, c);
+		T rx = x * c - y * s;
+		T ry = x * s + y * c;
 		x = rx;
 		y = ry;
 	}
 
-	void rotDeg(double deg) { double rad = deg / 180.0 * M_PI; rot(rad); }
+	void rotDeg(T deg) { T rad = deg / 180.0 * M_PI; rot(rad); }
 
-	double dot(const Vec2& v) { return x * v.x + y * v.y; }
-	double cosBetween(const Vec2& v) { double l= len()*v.len(); return (l==0.0 ? 0.0 : dot(v)/l); }	// cosine of the angle between the two vectors
+	T dot(const Vec2T& v) { return x * v.x + y * v.y; }
+	T cosBetween(const Vec2T& v) { T l= len()*v.len(); return (l==0.0 ? T(0.0) : dot(v)/l); }	// cosine of the angle between the two vectors
 };
 
+typedef Vec2T<R2Scalar> Vec2;	// the vector of the simulator
+typedef Vec2T<float> Vec2f;
+typedef Vec2T<double> Vec2d;
+
 } // end namespace
 #endif // VEC2_H
 